@@ -191,7 +191,7 @@ if [ ${FIX} = 1 ]; then
         clang-format \
         ${CLANG_FORMAT_VERBOSE} \
         -i \
-        ::: src/*
+        ::: src/* bench/*
 
     set_exit \
         cmake-format \
@@ -216,7 +216,7 @@ else
         parallel \
         -j ${JOBS} \
         check_formatted \
-        ::: src/*
+        ::: src/* bench/*
 fi
 
 if [[ $VERBOSE -gt 1 ]]; then
@@ -230,6 +230,7 @@ exit_on_failure \
     cmake \
     ${CMAKE_VERBOSE} \
     -DCMAKE_EXPORT_COMPILE_COMMANDS=On \
+    -DXAWI_BUILD_BENCHMARKS=On \
     -DCMAKE_C_COMPILER=clang \
     -DCMAKE_CXX_COMPILER=clang++ \
     .
@@ -297,7 +298,7 @@ set_exit \
     ${CLANG_TIDY_FIX} \
     ${CLANG_TIDY_VERBOSE} \
     -j ${JOBS} \
-    src
+    src bench
 
 CPPCHECK_FILTER=(
     # TODO(tomKPZ): Enable this.
@@ -320,7 +321,7 @@ set_exit \
     --enable=all \
     ${CPPCHECK_FILTER[@]} \
     --force \
-    src
+    src bench
 
 CPPLINT_FILTER=(
     # This project uses "#pragma once".
@@ -347,7 +348,7 @@ set_exit \
     cpplint \
     --filter="$(join_by , ${CPPLINT_FILTER[@]})" \
     ${CPPLINT_VERBOSE} \
-    ::: src/*
+    ::: src/* bench/*
 
 if [[ $EXITCODE -ne 0 ]]; then
     >&2 echo "Checks failed."
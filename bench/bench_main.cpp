@@ -0,0 +1,583 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include <getopt.h>
+#include <xcb/xcb.h>
+#include <xcb/xinput.h>
+#include <xcb/xproto.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "active_window_indicator.h"
+#include "allocation_counter.h"
+#include "benchmark_runner.h"
+#include "border_window.h"
+#include "command_line.h"
+#include "connection.h"
+#include "event.h"
+#include "event_handler.h"
+#include "event_loop.h"
+#include "event_loop_idle_observer.h"
+#include "event_mask_table.h"
+#include "fake_x_server.h"
+#include "key_listener.h"
+#include "lippincott.h"
+#include "observable.h"
+#include "request_stats.h"
+#include "scoped_event_handlers.h"
+#include "scoped_observer.h"
+#include "startup_info.h"
+#include "startup_profile.h"
+#include "window_geometry_observer.h"
+#include "window_geometry_tracker.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kMinTime{200};
+
+// The synthetic tree is a chain of kMaxDepth windows below the root, as
+// left by a window manager that reparents into nested frames.
+constexpr xcb_window_t kChainBase = 0x1000;
+constexpr std::size_t kMaxDepth = 32;
+constexpr std::array<std::size_t, 3> kDepths{2, 8, kMaxDepth};
+
+// A window that only the EventLoop benchmark listens on.
+constexpr xcb_window_t kCountedWindow = 0x2000;
+
+constexpr uint8_t kOtherKey = 38;
+constexpr uint8_t kSuperKey = 133;
+
+// The active window for the ActiveWindowIndicator benchmarks.
+constexpr std::size_t kActiveDepth = 8;
+
+// Handling an event or an idle pass must not allocate once the border is
+// showing.
+constexpr double kNoAllocations = 0;
+
+// Showing and hiding the border with the active window at kActiveDepth
+// allocates a geometry tracker with its requests and observers.  Built
+// with GCC 12 and libstdc++, both the default and the Release build type
+// measure 180.28 allocations per activation with either border strategy:
+// 180 for the trackers, plus the amortized growth of long-lived
+// containers.  Rounded up, so that any new allocation fails the budget.
+constexpr double kActivationAllocations = 181;
+
+// Returns the window |depth| levels below the root on the chain.
+auto ChainWindow(std::size_t depth) -> xcb_window_t {
+  return kChainBase + CheckedCast<xcb_window_t>(depth) - 1;
+}
+
+void AddWindows(FakeXServer* server) {
+  xcb_window_t parent = FakeXServer::kRootWindow;
+  for (std::size_t depth = 1; depth <= kMaxDepth; depth++) {
+    server->AddWindow(ChainWindow(depth), parent, 1, 1, 800, 600);
+    parent = ChainWindow(depth);
+  }
+  server->AddWindow(kCountedWindow, FakeXServer::kRootWindow, 0, 0, 1, 1);
+}
+
+class CountingObserver : public WindowGeometryObserver {
+ public:
+  CountingObserver() = default;
+  ~CountingObserver() override = default;
+
+  [[nodiscard]] auto changes() const -> uint64_t { return changes_; }
+
+ protected:
+  // WindowGeometryObserver:
+  void WindowPositionChanged() override { changes_++; }
+
+ private:
+  uint64_t changes_ = 0;
+
+  DELETE_SPECIAL_MEMBERS(CountingObserver);
+};
+
+class NotifyingObservable : public Observable<WindowGeometryObserver> {
+ public:
+  NotifyingObservable() = default;
+  ~NotifyingObservable() override = default;
+
+  void Notify() {
+    for (auto* observer : observers()) {
+      observer->WindowPositionChanged();
+    }
+  }
+
+ private:
+  DELETE_SPECIAL_MEMBERS(NotifyingObservable);
+};
+
+// Quits |event_loop| once |tracker| has the geometry of all of its
+// ancestors.
+class ReadyWaiter : public WindowGeometryObserver {
+ public:
+  ReadyWaiter(EventLoop* event_loop, WindowGeometryTracker* tracker)
+      : event_loop_(event_loop), tracker_(tracker), observer_(this, tracker) {}
+  ~ReadyWaiter() override = default;
+
+ protected:
+  // WindowGeometryObserver:
+  void WindowPositionChanged() override { QuitIfReady(); }
+  void WindowSizeChanged() override { QuitIfReady(); }
+  void WindowBorderWidthChanged() override { QuitIfReady(); }
+
+ private:
+  void QuitIfReady() {
+    if (tracker_->Ready()) {
+      event_loop_->Quit();
+    }
+  }
+
+  EventLoop* event_loop_;
+  WindowGeometryTracker* tracker_;
+  ScopedObserver<WindowGeometryObserver> observer_;
+
+  DELETE_SPECIAL_MEMBERS(ReadyWaiter);
+};
+
+// Quits |event_loop| after a given number of PropertyNotify events on
+// kCountedWindow.
+class EventCounter {
+ public:
+  explicit EventCounter(EventLoop* event_loop)
+      : event_loop_(event_loop),
+        event_handlers_(
+            event_loop_,
+            {EventHandler::ForWindow<&EventCounter::OnPropertyNotify>(
+                this, kCountedWindow)}) {}
+
+  void Expect(uint64_t events) { remaining_ = events; }
+
+ private:
+  void OnPropertyNotify(const xcb_property_notify_event_t& /*property*/) {
+    if (--remaining_ == 0) {
+      event_loop_->Quit();
+    }
+  }
+
+  EventLoop* event_loop_;
+  ScopedEventHandlers event_handlers_;
+  uint64_t remaining_ = 0;
+
+  DELETE_SPECIAL_MEMBERS(EventCounter);
+};
+
+// Quits |event_loop| at the end of an idle pass in which the condition
+// passed to QuitWhen() holds.  Idle observers run newest first, so one
+// made before the indicator runs after the indicator's idle work.
+class IdleQuitter : public EventLoopIdleObserver {
+ public:
+  explicit IdleQuitter(EventLoop* event_loop)
+      : event_loop_(event_loop), observer_(this, event_loop) {}
+  ~IdleQuitter() override = default;
+
+  void QuitWhen(std::function<bool()> done) { done_ = std::move(done); }
+
+ protected:
+  // EventLoopIdleObserver:
+  void OnIdle() override {
+    if (done_ && done_()) {
+      event_loop_->Quit();
+    }
+  }
+
+ private:
+  EventLoop* event_loop_;
+  ScopedObserver<EventLoopIdleObserver> observer_;
+  std::function<bool()> done_;
+
+  DELETE_SPECIAL_MEMBERS(IdleQuitter);
+};
+
+// Dispatches |event| as EventLoop::Run() would, including charging its
+// allocations to the event phase.
+auto Dispatch(EventLoop* event_loop, const void* event) -> bool {
+  ScopedAllocationPhase event_phase(AllocationPhase::kEvent);
+  return event_loop->event_router()->Dispatch(
+      Event::Borrow(static_cast<const xcb_generic_event_t*>(event)));
+}
+
+// Runs the idle work of |observer| as an idle pass would.
+void RunIdle(EventLoopIdleObserver* observer) {
+  ScopedAllocationPhase idle_phase(AllocationPhase::kIdle);
+  observer->OnIdle();
+}
+
+// Runs |body| and throws std::runtime_error if it blocked on a reply, or
+// if it sent more than |max_requests| of the requests that RequestStats
+// counts.  Unlike budgets, this also runs when |name| is filtered out.
+void CheckRoundTrips(Connection* connection,
+                     const std::string& name,
+                     uint64_t max_requests,
+                     const std::function<void()>& body) {
+  // Do not charge |body| for event masks left to commit by earlier work.
+  connection->CommitEventMasks();
+  const RequestCounts before = connection->request_stats().Totals();
+  body();
+  const RequestCounts after = connection->request_stats().Totals();
+  const uint64_t sync_round_trips =
+      after.sync_round_trips - before.sync_round_trips;
+  const uint64_t requests = after.requests - before.requests;
+  if (sync_round_trips != 0) {
+    throw std::runtime_error(name + " made " +
+                             std::to_string(sync_round_trips) +
+                             " synchronous round trips");
+  }
+  if (requests > max_requests) {
+    throw std::runtime_error(name + " sent " + std::to_string(requests) +
+                             " requests, expected at most " +
+                             std::to_string(max_requests));
+  }
+}
+
+// Throws std::runtime_error unless a tracker ignores a ConfigureNotify
+// that was generated before it queried its window, but applies one that
+// was generated after.  EventBatch dispatches the older event after the
+// reply when an event that overtook it made the indicator track the
+// window anew.
+void CheckStaleGeometry(Connection* connection,
+                        EventLoop* event_loop,
+                        FakeXServer* server) {
+  const uint16_t stale_sequence = server->sequence();
+  WindowGeometryTracker tracker(connection, event_loop, ChainWindow(1));
+  {
+    ReadyWaiter waiter(event_loop, &tracker);
+    event_loop->Run();
+  }
+  const int16_t x = tracker.X();
+  xcb_configure_notify_event_t configure{};
+  configure.response_type = XCB_CONFIGURE_NOTIFY;
+  configure.sequence = stale_sequence;
+  configure.event = ChainWindow(1);
+  configure.window = ChainWindow(1);
+  configure.x = CheckedCast<int16_t>(x + 1);
+  configure.width = tracker.width();
+  configure.height = tracker.height();
+  Dispatch(event_loop, &configure);
+  if (tracker.X() != x) {
+    throw std::runtime_error(
+        "WindowGeometryTracker applied a ConfigureNotify older than its "
+        "GetGeometry reply");
+  }
+  configure.sequence = server->sequence();
+  Dispatch(event_loop, &configure);
+  if (tracker.X() == x) {
+    throw std::runtime_error(
+        "WindowGeometryTracker ignored a ConfigureNotify newer than its "
+        "GetGeometry reply");
+  }
+}
+
+void BenchObservable(BenchmarkRunner* runner) {
+  for (std::size_t num_observers : {1U, 8U, 64U}) {
+    NotifyingObservable observable;
+    std::vector<std::unique_ptr<CountingObserver>> observers;
+    std::vector<std::unique_ptr<ScopedObserver<WindowGeometryObserver>>>
+        scoped_observers;
+    for (std::size_t i = 0; i < num_observers; i++) {
+      observers.push_back(std::make_unique<CountingObserver>());
+      scoped_observers.push_back(
+          std::make_unique<ScopedObserver<WindowGeometryObserver>>(
+              observers.back().get(), &observable));
+    }
+    runner->Run("Observable/Notify/observers=" + std::to_string(num_observers),
+                [&](uint64_t iterations) {
+                  for (uint64_t i = 0; i < iterations; i++) {
+                    observable.Notify();
+                  }
+                });
+    DoNotOptimize(observers.front()->changes());
+
+    CountingObserver observer;
+    runner->Run(
+        "ScopedObserver/AddRemove/observers=" + std::to_string(num_observers),
+        [&](uint64_t iterations) {
+          for (uint64_t i = 0; i < iterations; i++) {
+            ScopedObserver<WindowGeometryObserver> scoped_observer(
+                &observer, &observable);
+          }
+        });
+  }
+}
+
+void BenchMultiMask(BenchmarkRunner* runner) {
+  MultiMask mask;
+  mask.AddMask(XCB_EVENT_MASK_PROPERTY_CHANGE);
+  runner->Run("MultiMask/AddRemove", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+      mask.AddMask(XCB_EVENT_MASK_STRUCTURE_NOTIFY);
+      DoNotOptimize(mask);
+      mask.RemoveMask(XCB_EVENT_MASK_STRUCTURE_NOTIFY);
+      DoNotOptimize(mask);
+    }
+  });
+  runner->Run("MultiMask/ToMask", [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+      DoNotOptimize(mask);
+      DoNotOptimize(mask.ToMask());
+    }
+  });
+}
+
+void BenchWindowGeometryTracker(BenchmarkRunner* runner,
+                                Connection* connection,
+                                EventLoop* event_loop,
+                                FakeXServer* server) {
+  for (std::size_t depth : kDepths) {
+    const auto suffix = "/depth=" + std::to_string(depth);
+    runner->Run("WindowGeometryTracker/Construct" + suffix,
+                [&](uint64_t iterations) {
+                  for (uint64_t i = 0; i < iterations; i++) {
+                    WindowGeometryTracker tracker(connection, event_loop,
+                                                  ChainWindow(depth));
+                    ReadyWaiter waiter(event_loop, &tracker);
+                    event_loop->Run();
+                  }
+                });
+
+    WindowGeometryTracker tracker(connection, event_loop, ChainWindow(depth));
+    {
+      ReadyWaiter waiter(event_loop, &tracker);
+      event_loop->Run();
+    }
+    CountingObserver observer;
+    ScopedObserver<WindowGeometryObserver> scoped_observer(&observer,
+                                                           &tracker);
+    // Moving the outermost frame moves every window below it.
+    xcb_configure_notify_event_t configure{};
+    configure.response_type = XCB_CONFIGURE_NOTIFY;
+    configure.sequence = server->sequence();
+    configure.event = ChainWindow(1);
+    configure.window = ChainWindow(1);
+    configure.y = 1;
+    configure.width = 800;
+    configure.height = 600;
+    runner->Run("WindowGeometryTracker/ConfigureNotify" + suffix,
+                kNoAllocations, [&](uint64_t iterations) {
+                  for (uint64_t i = 0; i < iterations; i++) {
+                    configure.x = static_cast<int16_t>(i & 1);
+                    Dispatch(event_loop, &configure);
+                  }
+                });
+    DoNotOptimize(observer.changes());
+  }
+}
+
+void BenchKeyListener(BenchmarkRunner* runner,
+                      Connection* connection,
+                      EventLoop* event_loop,
+                      const StartupInfo& startup_info) {
+  KeyListener key_listener(connection, event_loop, startup_info);
+  xcb_input_key_press_event_t key{};
+  key.response_type = XCB_GE_GENERIC;
+  key.extension = startup_info.xinput_major_opcode();
+  key.event_type = XCB_INPUT_KEY_PRESS;
+  key.detail = kOtherKey;
+  runner->Run("KeyListener/OtherKey", kNoAllocations,
+              [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                  Dispatch(event_loop, &key);
+                }
+              });
+
+  key.detail = kSuperKey;
+  runner->Run("KeyListener/SuperPressRelease", kNoAllocations,
+              [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                  key.event_type = (i & 1) == 0 ? XCB_INPUT_KEY_PRESS
+                                                : XCB_INPUT_KEY_RELEASE;
+                  Dispatch(event_loop, &key);
+                }
+              });
+  // Leave the key released.
+  key.event_type = XCB_INPUT_KEY_RELEASE;
+  Dispatch(event_loop, &key);
+}
+
+void BenchEventLoop(BenchmarkRunner* runner,
+                    Connection* connection,
+                    EventLoop* event_loop,
+                    FakeXServer* server) {
+  connection->SelectEvents(kCountedWindow, XCB_EVENT_MASK_PROPERTY_CHANGE);
+  EventCounter counter(event_loop);
+  xcb_property_notify_event_t property{};
+  property.response_type = XCB_PROPERTY_NOTIFY;
+  property.window = kCountedWindow;
+  property.atom = XCB_ATOM_WM_NAME;
+  runner->Run("EventLoop/PropertyNotify", kNoAllocations,
+              [&](uint64_t iterations) {
+                counter.Expect(iterations);
+                server->SendEvent(
+                    reinterpret_cast<const xcb_generic_event_t&>(property),
+                    iterations);
+                event_loop->Run();
+              });
+  connection->DeselectEvents(kCountedWindow, XCB_EVENT_MASK_PROPERTY_CHANGE);
+}
+
+void BenchActiveWindowIndicator(BenchmarkRunner* runner,
+                                Connection* connection,
+                                EventLoop* event_loop,
+                                FakeXServer* server,
+                                const StartupInfo& startup_info,
+                                char* program,
+                                const std::string& strategy) {
+  const std::string prefix = "ActiveWindowIndicator/" + strategy;
+  std::string strategy_arg = "--border-strategy=" + strategy;
+  std::array<char*, 2> args{program, strategy_arg.data()};
+  // getopt_long() keeps its position in a global.
+  optind = 0;
+  CommandLine command_line{CheckedCast<int>(args.size()), args.data()};
+
+  uint64_t shown_updates = 0;
+  IdleQuitter quitter(event_loop);
+  ActiveWindowIndicator indicator(connection, event_loop, &command_line,
+                                  startup_info);
+  const auto& border = indicator.border_window();
+  // Showing the border moves, resizes and maps it.
+  quitter.QuitWhen([&]() { return border.updates() >= shown_updates; });
+
+  xcb_input_key_press_event_t key{};
+  key.response_type = XCB_GE_GENERIC;
+  key.extension = startup_info.xinput_major_opcode();
+  key.detail = kSuperKey;
+  const auto show = [&]() {
+    shown_updates = border.updates() + 3;
+    key.event_type = XCB_INPUT_KEY_PRESS;
+    Dispatch(event_loop, &key);
+    event_loop->Run();
+  };
+  const auto hide = [&]() {
+    key.event_type = XCB_INPUT_KEY_RELEASE;
+    Dispatch(event_loop, &key);
+  };
+
+  // The border is one shaped window, or four unshaped edge windows.
+  // Moving configures each window.  Resizing does too, and a shaped window
+  // also creates, sets and destroys a bounding and an input region.
+  const bool edges = strategy == "edges";
+  const uint64_t border_windows = edges ? 4 : 1;
+  const uint64_t move_requests = border_windows;
+  const uint64_t resize_requests = edges ? border_windows : 1 + 2 * 3;
+
+  // The active window is already tracked, so showing the border selects
+  // events on the window and its ancestors up to the root and queries
+  // each of them asynchronously with a QueryTree and a GetGeometry.  The
+  // border is then moved, resized, mapped and raised.  Hiding unmaps it.
+  CheckRoundTrips(connection, prefix + "/Show",
+                  3 * (kActiveDepth + 1) + move_requests + resize_requests +
+                      2 * border_windows,
+                  show);
+  CheckRoundTrips(connection, prefix + "/Hide", border_windows, hide);
+
+  runner->Run(prefix + "/Activate/depth=" + std::to_string(kActiveDepth),
+              kActivationAllocations,
+              [&](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                  show();
+                  hide();
+                }
+              });
+
+  show();
+  auto* idle_observer = static_cast<EventLoopIdleObserver*>(&indicator);
+  // Moving the outermost frame moves the active window.
+  xcb_configure_notify_event_t configure{};
+  configure.response_type = XCB_CONFIGURE_NOTIFY;
+  configure.sequence = server->sequence();
+  configure.event = ChainWindow(1);
+  configure.window = ChainWindow(1);
+  configure.y = 1;
+  configure.width = 800;
+  configure.height = 600;
+  const auto move = [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+      configure.x = static_cast<int16_t>(i & 1);
+      Dispatch(event_loop, &configure);
+      RunIdle(idle_observer);
+    }
+  };
+  CheckRoundTrips(connection, prefix + "/Move", 2 * move_requests,
+                  [&]() { move(2); });
+  runner->Run(prefix + "/Move", kNoAllocations, move);
+
+  configure.event = ChainWindow(kActiveDepth);
+  configure.window = ChainWindow(kActiveDepth);
+  configure.x = 1;
+  const auto resize = [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+      configure.width = static_cast<uint16_t>(800 + (i & 1));
+      Dispatch(event_loop, &configure);
+      RunIdle(idle_observer);
+    }
+  };
+  CheckRoundTrips(connection, prefix + "/Resize", 2 * resize_requests,
+                  [&]() { resize(2); });
+  runner->Run(prefix + "/Resize", kNoAllocations, resize);
+  hide();
+  DoNotOptimize(border.updates());
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) noexcept -> int {
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [FILTER]" << std::endl;
+    return 1;
+  }
+  try {
+    BenchmarkRunner runner(&std::cout, argc == 2 ? argv[1] : "", kMinTime);
+    BenchObservable(&runner);
+    BenchMultiMask(&runner);
+
+    FakeXServer server;
+    AddWindows(&server);
+    server.SetActiveWindow(ChainWindow(kActiveDepth));
+    // The indicator's own options are not used, so parse none of them.
+    CommandLine command_line{1, argv};
+    Connection connection{&command_line, &server};
+    StartupProfile startup_profile;
+    StartupInfo startup_info{&connection, &startup_profile};
+    EventLoop event_loop{&connection, &command_line};
+    CheckStaleGeometry(&connection, &event_loop, &server);
+    BenchWindowGeometryTracker(&runner, &connection, &event_loop, &server);
+    BenchKeyListener(&runner, &connection, &event_loop, startup_info);
+    BenchEventLoop(&runner, &connection, &event_loop, &server);
+    for (const char* strategy : {"shape", "edges"}) {
+      BenchActiveWindowIndicator(&runner, &connection, &event_loop, &server,
+                                 startup_info, argv[0], strategy);
+    }
+    if (!runner.budgets_met()) {
+      return 1;
+    }
+  } catch (...) {
+    Lippincott();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "benchmark_runner.h"
+
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+#include "allocation_counter.h"
+
+namespace {
+
+constexpr int kNameWidth = 52;
+
+// Caps the iteration count of benchmarks that finish suspiciously fast,
+// such as ones the compiler optimized away.
+constexpr uint64_t kMaxIterations = uint64_t{1} << 32;
+
+}  // namespace
+
+BenchmarkRunner::BenchmarkRunner(std::ostream* stream,
+                                 std::string filter,
+                                 std::chrono::milliseconds min_time)
+    : stream_(stream), filter_(std::move(filter)), min_time_(min_time) {
+  *stream_ << std::left << std::setw(kNameWidth) << "benchmark" << std::right
+           << std::setw(12) << "iterations" << std::setw(14) << "ns/op"
+           << std::setw(14) << "allocs/op" << std::endl;
+}
+
+BenchmarkRunner::~BenchmarkRunner() = default;
+
+void BenchmarkRunner::Run(const std::string& name, const Body& body) {
+  Measure(name, body);
+}
+
+void BenchmarkRunner::Run(const std::string& name,
+                          double max_allocations,
+                          const Body& body) {
+  auto allocations = Measure(name, body);
+  if (allocations && *allocations > max_allocations) {
+    *stream_ << name << " exceeds its budget of " << max_allocations
+             << " allocs/op" << std::endl;
+    budgets_met_ = false;
+  }
+}
+
+auto BenchmarkRunner::Measure(const std::string& name, const Body& body)
+    -> std::optional<double> {
+  if (!Matches(name)) {
+    return std::nullopt;
+  }
+  // Warm up caches and lazily initialized state.
+  body(1);
+
+  uint64_t iterations = 1;
+  std::chrono::nanoseconds elapsed{};
+  uint64_t allocations = 0;
+  uint64_t charged_allocations = 0;
+  while (true) {
+    const uint64_t start_allocations = AllocationCounter::ThreadAllocations();
+    const uint64_t start_uncharged =
+        AllocationCounter::ThreadAllocations(AllocationPhase::kNone);
+    const auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    elapsed = std::chrono::steady_clock::now() - start;
+    allocations = AllocationCounter::ThreadAllocations() - start_allocations;
+    charged_allocations =
+        allocations -
+        (AllocationCounter::ThreadAllocations(AllocationPhase::kNone) -
+         start_uncharged);
+    if (elapsed >= min_time_ || iterations >= kMaxIterations) {
+      break;
+    }
+    iterations *= 2;
+  }
+
+  const auto per_op = [iterations](double total) {
+    return total / static_cast<double>(iterations);
+  };
+  *stream_ << std::left << std::setw(kNameWidth) << name << std::right
+           << std::setw(12) << iterations << std::fixed << std::setprecision(1)
+           << std::setw(14) << per_op(static_cast<double>(elapsed.count()))
+           << std::setprecision(2) << std::setw(14)
+           << per_op(static_cast<double>(allocations)) << std::endl;
+  return per_op(static_cast<double>(charged_allocations));
+}
+
+auto BenchmarkRunner::Matches(const std::string& name) const -> bool {
+  return name.find(filter_) != std::string::npos;
+}
@@ -0,0 +1,76 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+#include "util.h"
+
+// Keeps the compiler from optimizing away the computation of |value|.
+template <typename T>
+void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs benchmarks and prints the time and the number of allocations that
+// each operation took.
+class BenchmarkRunner {
+ public:
+  using Body = std::function<void(uint64_t iterations)>;
+
+  // Only benchmarks whose name contains |filter| are run.  Each one is
+  // repeated with twice the iterations until a run takes |min_time|.
+  BenchmarkRunner(std::ostream* stream,
+                  std::string filter,
+                  std::chrono::milliseconds min_time);
+  ~BenchmarkRunner();
+
+  // Runs |body|, which must perform |iterations| operations, and prints
+  // the cost of one.  Setup that should not be measured belongs outside
+  // |body|.
+  void Run(const std::string& name, const Body& body);
+
+  // Like Run(), but the benchmark fails if an operation allocates more
+  // than |max_allocations| times on average in the indicator's own
+  // phases, that is outside AllocationPhase::kNone.  Setup in |body|,
+  // such as queueing events on the fake server, is not charged.
+  void Run(const std::string& name, double max_allocations, const Body& body);
+
+  [[nodiscard]] auto Matches(const std::string& name) const -> bool;
+
+  // Returns false if a benchmark exceeded its allocation budget.
+  [[nodiscard]] auto budgets_met() const -> bool { return budgets_met_; }
+
+ private:
+  // Returns the allocations per operation outside AllocationPhase::kNone,
+  // or nullopt if |name| does not match the filter.
+  auto Measure(const std::string& name, const Body& body)
+      -> std::optional<double>;
+
+  std::ostream* stream_;
+  std::string filter_;
+  std::chrono::milliseconds min_time_;
+  bool budgets_met_ = true;
+
+  DELETE_SPECIAL_MEMBERS(BenchmarkRunner);
+};
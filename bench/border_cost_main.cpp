@@ -0,0 +1,259 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+// Compares what border strategies cost per update.  For each strategy a
+// fresh Xvfb and indicator are started, the active window is moved and
+// resized step by step, and each step waits for the border to follow so
+// that every step is exactly one border update.  The indicator talks to
+// Xvfb through XProxy, which counts its requests and bytes.  The X server
+// CPU time also includes the stand-in window manager's requests and the
+// events sent to this process, which are the same for every strategy
+// except for the border's own structure events.
+
+#include <getopt.h>
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+#include <xcb/xtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "border_watcher.h"
+#include "child_process.h"
+#include "lippincott.h"
+#include "process_stats.h"
+#include "stand_in_wm.h"
+#include "x_error.h"
+#include "x_proxy.h"
+#include "xvfb.h"
+
+namespace {
+
+using Clock = BorderWatcher::Clock;
+
+constexpr uint16_t kScreenWidth = 1920;
+constexpr uint16_t kScreenHeight = 1080;
+constexpr xcb_rectangle_t kClient{200, 200, 640, 480};
+
+// How far each move goes and how much each resize grows or shrinks.
+constexpr int16_t kMoveStep = 8;
+constexpr int32_t kResizeStep = 16;
+
+// The left Super key, which KeyListener listens for.
+constexpr uint8_t kSuperKeycode = 133;
+
+constexpr std::chrono::milliseconds kStartupTimeout{10000};
+constexpr std::chrono::milliseconds kTimeout{2000};
+
+// The border can appear to be in place before the last of its requests
+// arrive, so the final counts are taken after this long.
+constexpr std::chrono::milliseconds kSettleTime{100};
+
+constexpr uint64_t kDefaultUpdates = 2000;
+
+const char* k_usage_message = R"(
+usage: xawi-border-cost [-h] [-n N] [-s STRATEGY]... [-i PATH]
+                        [-- INDICATOR_ARGS...]
+
+Moves and resizes the active window under Xvfb, which must be in $PATH,
+and reports what each border update costs with each border strategy
+
+optional arguments:
+  -h, --help               show this help message and exit
+  -n, --updates N          border updates per strategy, alternating
+                           moves and resizes; default 2000
+  -s, --strategy STRATEGY  a value of the indicator's --border-strategy to
+                           measure; may be repeated; default all of them
+  -i, --indicator PATH     indicator binary; default
+                           x-active-window-indicator next to this binary
+)";
+
+struct Options {
+  uint64_t updates = kDefaultUpdates;
+  std::vector<std::string> strategies;
+  std::string indicator;
+  std::vector<std::string> indicator_args;
+};
+
+struct Result {
+  std::string strategy;
+  Clock::duration elapsed{};
+  std::chrono::nanoseconds xvfb_cpu{};
+  std::chrono::nanoseconds indicator_cpu{};
+  XProxy::Counts traffic;
+};
+
+// Returns false if the program should exit after printing the usage.
+auto ParseOptions(int argc, char** argv, Options* options) -> bool {
+  options->indicator = SiblingExecutablePath("x-active-window-indicator");
+  constexpr std::array<struct option, 5> kLongOptions{{
+      {"help", no_argument, nullptr, 'h'},
+      {"updates", required_argument, nullptr, 'n'},
+      {"strategy", required_argument, nullptr, 's'},
+      {"indicator", required_argument, nullptr, 'i'},
+      {nullptr, 0, nullptr, 0},
+  }};
+  while (true) {
+    int c = getopt_long(argc, argv, "hn:s:i:", kLongOptions.data(), nullptr);
+    if (c == -1) {
+      break;
+    }
+    switch (c) {
+      case 'n':
+        options->updates = std::stoull(optarg);
+        break;
+      case 's':
+        options->strategies.emplace_back(optarg);
+        break;
+      case 'i':
+        options->indicator = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (options->strategies.empty()) {
+    options->strategies = {"shape", "edges"};
+  }
+  options->indicator_args.assign(argv + optind, argv + argc);
+  return true;
+}
+
+auto Measure(const Options& options, const std::string& strategy)
+    -> Result {
+  Xvfb xvfb(kScreenWidth, kScreenHeight);
+  XProxy proxy(xvfb.display());
+  std::unique_ptr<xcb_connection_t, decltype(&xcb_disconnect)> connection(
+      xcb_connect(xvfb.display().c_str(), nullptr), &xcb_disconnect);
+  if (xcb_connection_has_error(connection.get()) != 0) {
+    throw XError("Could not connect to " + xvfb.display());
+  }
+  auto* c = connection.get();
+
+  StandInWm wm(c);
+  const xcb_window_t client = wm.CreateClient(kClient);
+  wm.Activate(client);
+  BorderWatcher watcher(c, wm.root());
+
+  std::vector<std::string> indicator_argv{options.indicator,
+                                          "--border-strategy", strategy};
+  indicator_argv.insert(indicator_argv.end(), options.indicator_args.begin(),
+                        options.indicator_args.end());
+  ChildProcess indicator(indicator_argv, {"DISPLAY=" + proxy.display()});
+  const auto border_covers_client = [&](const BorderWatcher::State& state) {
+    return BorderWatcher::Covers(state, wm.ClientGeometry(client));
+  };
+  watcher.WaitUntil(
+      [](const BorderWatcher::State& state) { return state.created; },
+      kStartupTimeout);
+  xcb_test_fake_input(c, XCB_KEY_PRESS, kSuperKeycode, XCB_CURRENT_TIME,
+                      XCB_WINDOW_NONE, 0, 0, 0);
+  watcher.WaitUntil(border_covers_client, kStartupTimeout);
+  std::this_thread::sleep_for(kSettleTime);
+
+  const auto start = Clock::now();
+  const auto xvfb_before = ProcessStats::Read(xvfb.pid());
+  const auto indicator_before = ProcessStats::Read(indicator.pid());
+  const auto traffic_before = proxy.counts();
+  for (uint64_t i = 0; i < options.updates; i++) {
+    // Moves go back and forth, and resizes grow and shrink, so the
+    // window stays on screen however many updates there are.
+    const auto& geometry = wm.ClientGeometry(client);
+    if (i % 2 == 0) {
+      const auto dx = CheckedCast<int16_t>(i % 4 == 0 ? kMoveStep : -kMoveStep);
+      wm.Move(client, CheckedCast<int16_t>(geometry.x + dx), geometry.y);
+    } else {
+      const int32_t delta = i % 4 == 1 ? kResizeStep : -kResizeStep;
+      wm.Resize(client, CheckedCast<uint16_t>(geometry.width + delta),
+                CheckedCast<uint16_t>(geometry.height + delta));
+    }
+    watcher.WaitUntil(border_covers_client, kTimeout);
+  }
+  std::this_thread::sleep_for(kSettleTime);
+  const auto traffic_after = proxy.counts();
+  const auto indicator_after = ProcessStats::Read(indicator.pid());
+  const auto xvfb_after = ProcessStats::Read(xvfb.pid());
+  const auto elapsed = Clock::now() - start;
+
+  xcb_test_fake_input(c, XCB_KEY_RELEASE, kSuperKeycode, XCB_CURRENT_TIME,
+                      XCB_WINDOW_NONE, 0, 0, 0);
+  xcb_flush(c);
+
+  return {strategy,
+          elapsed,
+          xvfb_after.cpu_time - xvfb_before.cpu_time,
+          indicator_after.cpu_time - indicator_before.cpu_time,
+          {traffic_after.requests - traffic_before.requests,
+           traffic_after.bytes_sent - traffic_before.bytes_sent,
+           traffic_after.bytes_received - traffic_before.bytes_received}};
+}
+
+void PrintResults(std::ostream& stream,
+                  const std::vector<Result>& results,
+                  uint64_t updates) {
+  const auto per_update = [updates](auto value) {
+    return static_cast<double>(value) / static_cast<double>(updates);
+  };
+  const auto micros = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  };
+  stream << "Per border update, over " << updates << " updates:\n"
+         << std::left << std::setw(10) << "strategy" << std::right
+         << std::setw(12) << "Xvfb us" << std::setw(14) << "indicator us"
+         << std::setw(10) << "requests" << std::setw(12) << "bytes sent"
+         << std::setw(16) << "bytes received" << '\n'
+         << std::fixed << std::setprecision(1);
+  for (const auto& result : results) {
+    stream << std::left << std::setw(10) << result.strategy << std::right
+           << std::setw(12) << per_update(micros(result.xvfb_cpu))
+           << std::setw(14) << per_update(micros(result.indicator_cpu))
+           << std::setw(10) << per_update(result.traffic.requests)
+           << std::setw(12) << per_update(result.traffic.bytes_sent)
+           << std::setw(16) << per_update(result.traffic.bytes_received)
+           << '\n';
+  }
+  stream << std::flush;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) noexcept -> int {
+  try {
+    Options options;
+    if (!ParseOptions(argc, argv, &options) || options.updates == 0) {
+      std::cerr << k_usage_message << std::endl;
+      return 1;
+    }
+
+    std::vector<Result> results;
+    for (const auto& strategy : options.strategies) {
+      results.push_back(Measure(options, strategy));
+    }
+    PrintResults(std::cout, results, options.updates);
+  } catch (...) {
+    Lippincott();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,177 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "border_watcher.h"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "p_error.h"
+#include "x_error.h"
+
+BorderWatcher::BorderWatcher(xcb_connection_t* connection, xcb_window_t root)
+    : connection_(connection) {
+  const uint32_t event_mask = XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+  xcb_change_window_attributes(connection_, root, XCB_CW_EVENT_MASK,
+                               &event_mask);
+  xcb_flush(connection_);
+}
+
+BorderWatcher::~BorderWatcher() = default;
+
+auto BorderWatcher::WaitUntil(const Predicate& predicate,
+                              std::chrono::milliseconds timeout)
+    -> Clock::time_point {
+  xcb_flush(connection_);
+  const auto deadline = Clock::now() + timeout;
+  while (true) {
+    while (auto* event = xcb_poll_for_event(connection_)) {
+      const auto now = Clock::now();
+      std::unique_ptr<xcb_generic_event_t, FreeDeleter> owned_event(event);
+      Handle(*event);
+      if (predicate(state_)) {
+        return now;
+      }
+    }
+    if (xcb_connection_has_error(connection_) != 0) {
+      throw XError("Connection to the X server failed");
+    }
+    const auto remaining =
+        std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+    if (remaining.count() <= 0) {
+      throw std::runtime_error("Timed out waiting for the border window");
+    }
+    struct pollfd poll_fd {
+      xcb_get_file_descriptor(connection_), POLLIN, 0
+    };
+    if (REDO_ON_EINTR(poll(&poll_fd, 1, CheckedCast<int>(remaining.count()))) ==
+        -1) {
+      throw PError("poll");
+    }
+  }
+}
+
+void BorderWatcher::ProcessPendingEvents(const Listener& listener) {
+  while (auto* event = xcb_poll_for_event(connection_)) {
+    const auto now = Clock::now();
+    std::unique_ptr<xcb_generic_event_t, FreeDeleter> owned_event(event);
+    if (Handle(*event)) {
+      listener(state_, now);
+    }
+  }
+  if (xcb_connection_has_error(connection_) != 0) {
+    throw XError("Connection to the X server failed");
+  }
+}
+
+// static
+auto BorderWatcher::Covers(const State& state, const xcb_rectangle_t& geometry)
+    -> bool {
+  return state.mapped && state.geometry.x == geometry.x &&
+         state.geometry.y == geometry.y &&
+         state.geometry.width == geometry.width &&
+         state.geometry.height == geometry.height;
+}
+
+auto BorderWatcher::Handle(const xcb_generic_event_t& event) -> bool {
+  switch (event.response_type & ~0x80) {
+    case XCB_CREATE_NOTIFY: {
+      const auto& create =
+          reinterpret_cast<const xcb_create_notify_event_t&>(event);
+      if (create.override_redirect == 0) {
+        return false;
+      }
+      windows_[create.window] = {
+          false, {create.x, create.y, create.width, create.height}};
+      break;
+    }
+    case XCB_CONFIGURE_NOTIFY: {
+      const auto& configure =
+          reinterpret_cast<const xcb_configure_notify_event_t&>(event);
+      auto it = windows_.find(configure.window);
+      if (it == windows_.end()) {
+        return false;
+      }
+      it->second.geometry = {configure.x, configure.y, configure.width,
+                             configure.height};
+      break;
+    }
+    case XCB_MAP_NOTIFY: {
+      auto it = windows_.find(
+          reinterpret_cast<const xcb_map_notify_event_t&>(event).window);
+      if (it == windows_.end()) {
+        return false;
+      }
+      it->second.mapped = true;
+      break;
+    }
+    case XCB_UNMAP_NOTIFY: {
+      auto it = windows_.find(
+          reinterpret_cast<const xcb_unmap_notify_event_t&>(event).window);
+      if (it == windows_.end()) {
+        return false;
+      }
+      it->second.mapped = false;
+      break;
+    }
+    case XCB_DESTROY_NOTIFY:
+      if (windows_.erase(
+              reinterpret_cast<const xcb_destroy_notify_event_t&>(event)
+                  .window) == 0) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+  UpdateState();
+  return true;
+}
+
+void BorderWatcher::UpdateState() {
+  state_ = {};
+  state_.created = !windows_.empty();
+  for (const auto& [window, entry] : windows_) {
+    state_.mapped = state_.mapped || entry.mapped;
+  }
+  bool first = true;
+  int32_t left = 0;
+  int32_t top = 0;
+  int32_t right = 0;
+  int32_t bottom = 0;
+  for (const auto& [window, entry] : windows_) {
+    if (state_.mapped && !entry.mapped) {
+      continue;
+    }
+    const auto& geometry = entry.geometry;
+    const int32_t x = geometry.x;
+    const int32_t y = geometry.y;
+    left = first ? x : std::min(left, x);
+    top = first ? y : std::min(top, y);
+    right = first ? x + geometry.width : std::max(right, x + geometry.width);
+    bottom =
+        first ? y + geometry.height : std::max(bottom, y + geometry.height);
+    first = false;
+  }
+  state_.geometry = {
+      CheckedCast<int16_t>(left), CheckedCast<int16_t>(top),
+      CheckedCast<uint16_t>(right - left), CheckedCast<uint16_t>(bottom - top)};
+}
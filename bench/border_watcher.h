@@ -0,0 +1,87 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+
+#include "util.h"
+
+// Follows the indicator's border through the structure events of the
+// root window's children.  The border is made of the override-redirect
+// windows created on the root after this is constructed, so that it can
+// be followed whichever BorderStrategy draws it.
+class BorderWatcher {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct State {
+    bool created = false;
+    // Whether any of the border's windows is mapped.
+    bool mapped = false;
+    // The bounding box of the mapped windows, or of all of them while
+    // none is mapped.
+    xcb_rectangle_t geometry{};
+  };
+  using Predicate = std::function<bool(const State& state)>;
+  using Listener =
+      std::function<void(const State& state, Clock::time_point time)>;
+
+  // Selects SubstructureNotify on |root|.
+  BorderWatcher(xcb_connection_t* connection, xcb_window_t root);
+  ~BorderWatcher();
+
+  // Handles events until |predicate| holds, and returns when the event
+  // that made it hold was read.  Flushes first.  Throws
+  // std::runtime_error if |timeout| passes first.
+  auto WaitUntil(const Predicate& predicate, std::chrono::milliseconds timeout)
+      -> Clock::time_point;
+
+  // Handles the events that were already received without blocking, and
+  // runs |listener| with the time each one was read whenever the border
+  // changed.  Throws XError if the connection failed.
+  void ProcessPendingEvents(const Listener& listener);
+
+  // Returns true iff the border is mapped over exactly |geometry|.
+  static auto Covers(const State& state, const xcb_rectangle_t& geometry)
+      -> bool;
+
+  [[nodiscard]] auto state() const -> const State& { return state_; }
+
+ private:
+  struct Window {
+    bool mapped = false;
+    xcb_rectangle_t geometry{};
+  };
+
+  // Returns true iff |event| changed the border.
+  auto Handle(const xcb_generic_event_t& event) -> bool;
+
+  // Recomputes |state_| from |windows_|.
+  void UpdateState();
+
+  xcb_connection_t* connection_;
+  std::unordered_map<xcb_window_t, Window> windows_;
+  State state_;
+
+  DELETE_SPECIAL_MEMBERS(BorderWatcher);
+};
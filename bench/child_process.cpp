@@ -0,0 +1,103 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "child_process.h"
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+
+#include "p_error.h"
+
+extern char** environ;
+
+namespace {
+
+// Returns the name of the variable that |entry| sets, including the "=".
+auto VariableName(const std::string& entry) -> std::string {
+  return entry.substr(0, entry.find('=') + 1);
+}
+
+}  // namespace
+
+auto SiblingExecutablePath(const std::string& name) -> std::string {
+  std::array<char, 4096> path{};
+  auto size = readlink("/proc/self/exe", path.data(), path.size() - 1);
+  if (size <= 0) {
+    return name;
+  }
+  std::string self(path.data(), static_cast<std::size_t>(size));
+  return self.substr(0, self.rfind('/') + 1) + name;
+}
+
+ChildProcess::ChildProcess(const std::vector<std::string>& argv,
+                           const std::vector<std::string>& env) {
+  std::vector<std::string> environment;
+  for (char** entry = environ; *entry != nullptr; entry++) {
+    const std::string variable(*entry);
+    bool overridden = false;
+    for (const auto& override : env) {
+      overridden = overridden || VariableName(override) ==
+                                     VariableName(variable);
+    }
+    if (!overridden) {
+      environment.push_back(variable);
+    }
+  }
+  environment.insert(environment.end(), env.begin(), env.end());
+
+  const auto to_pointers = [](std::vector<std::string>& strings) {
+    std::vector<char*> pointers;
+    for (auto& string : strings) {
+      pointers.push_back(string.data());
+    }
+    pointers.push_back(nullptr);
+    return pointers;
+  };
+  std::vector<std::string> args = argv;
+  auto arg_pointers = to_pointers(args);
+  auto env_pointers = to_pointers(environment);
+  if (int error = posix_spawnp(&pid_, arg_pointers[0], nullptr, nullptr,
+                               arg_pointers.data(), env_pointers.data())) {
+    errno = error;
+    throw PError(("posix_spawnp " + args[0]).c_str());
+  }
+}
+
+ChildProcess::~ChildProcess() {
+  if (!Running()) {
+    return;
+  }
+  if (kill(pid_, SIGTERM) == -1) {
+    perror("kill");
+  }
+  if (REDO_ON_EINTR(waitpid(pid_, nullptr, 0)) == -1) {
+    perror("waitpid");
+  }
+}
+
+auto ChildProcess::Running() -> bool {
+  if (!exited_) {
+    exited_ = REDO_ON_EINTR(waitpid(pid_, nullptr, WNOHANG)) != 0;
+  }
+  return !exited_;
+}
@@ -0,0 +1,50 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+// Returns the path of the executable |name| in the directory of the
+// running executable, or just |name| if that directory is unknown.
+auto SiblingExecutablePath(const std::string& name) -> std::string;
+
+// A process that is terminated and reaped when this is destroyed.
+class ChildProcess {
+ public:
+  // Runs |argv|, looked up in $PATH, with the variables in |env| set in
+  // its environment.  Throws PError if it cannot be started.
+  explicit ChildProcess(const std::vector<std::string>& argv,
+                        const std::vector<std::string>& env = {});
+  ~ChildProcess();
+
+  [[nodiscard]] auto pid() const -> pid_t { return pid_; }
+
+  // Returns false once the process has exited.
+  auto Running() -> bool;
+
+ private:
+  pid_t pid_;
+  bool exited_ = false;
+
+  DELETE_SPECIAL_MEMBERS(ChildProcess);
+};
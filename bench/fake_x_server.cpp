@@ -0,0 +1,538 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "fake_x_server.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <xcb/xfixes.h>
+#include <xcb/xinput.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "p_error.h"
+
+namespace {
+
+// Size of an event, an error or the fixed part of a reply.
+constexpr std::size_t kPacketSize = 32;
+
+// |response_type| of replies and errors.
+constexpr uint8_t kReplyType = 1;
+constexpr uint8_t kErrorType = 0;
+
+// Size of the fixed part of the connection setup request.
+constexpr std::size_t kSetupRequestSize = 12;
+
+// Size of the fixed part of QueryExtension and InternAtom requests,
+// before the name.
+constexpr std::size_t kNamedRequestSize = 8;
+
+// Size of a GetProperty request.
+constexpr std::size_t kGetPropertySize = 24;
+
+// Events are moved to the output buffer in chunks of about this size, so
+// that a long stream of events does not have to be buffered at once.
+constexpr std::size_t kEventChunkSize = 64 * 1024;
+
+constexpr xcb_visualid_t kRootVisual = 0x21;
+constexpr xcb_colormap_t kDefaultColormap = 0x20;
+
+// Client resource IDs are allocated from here, clear of the server's own.
+constexpr uint32_t kResourceIdBase = 0x00200000;
+constexpr uint32_t kResourceIdMask = 0x001fffff;
+
+// Atoms interned by the client are numbered from one past the last
+// predefined atom.
+constexpr xcb_atom_t kFirstAtom = XCB_ATOM_WM_TRANSIENT_FOR + 1;
+
+auto Pad4(std::size_t size) -> std::size_t {
+  return (size + 3) & ~std::size_t{3};
+}
+
+template <typename T>
+auto Read(const uint8_t* data) -> T {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+template <typename T>
+void Append(std::vector<uint8_t>* buffer, const T& value) {
+  const auto* data = reinterpret_cast<const uint8_t*>(&value);
+  buffer->insert(buffer->end(), data, data + sizeof(value));
+}
+
+// Returns the reply to the connection setup request: one 24-bit TrueColor
+// screen with the root window kRootWindow.
+auto MakeSetup() -> std::vector<uint8_t> {
+  xcb_setup_t setup{};
+  setup.status = 1;
+  setup.protocol_major_version = 11;
+  setup.resource_id_base = kResourceIdBase;
+  setup.resource_id_mask = kResourceIdMask;
+  setup.maximum_request_length = UINT16_MAX;
+  setup.roots_len = 1;
+  setup.image_byte_order = XCB_IMAGE_ORDER_LSB_FIRST;
+  setup.bitmap_format_bit_order = XCB_IMAGE_ORDER_LSB_FIRST;
+  setup.bitmap_format_scanline_unit = 32;
+  setup.bitmap_format_scanline_pad = 32;
+  setup.min_keycode = 8;
+  setup.max_keycode = 255;
+
+  xcb_screen_t screen{};
+  screen.root = FakeXServer::kRootWindow;
+  screen.default_colormap = kDefaultColormap;
+  screen.white_pixel = 0xffffff;
+  screen.width_in_pixels = FakeXServer::kRootWidth;
+  screen.height_in_pixels = FakeXServer::kRootHeight;
+  screen.min_installed_maps = 1;
+  screen.max_installed_maps = 1;
+  screen.root_visual = kRootVisual;
+  screen.root_depth = 24;
+  screen.allowed_depths_len = 1;
+
+  xcb_depth_t depth{};
+  depth.depth = 24;
+  depth.visuals_len = 1;
+
+  xcb_visualtype_t visual{};
+  visual.visual_id = kRootVisual;
+  visual._class = XCB_VISUAL_CLASS_TRUE_COLOR;
+  visual.bits_per_rgb_value = 8;
+  visual.colormap_entries = 256;
+  visual.red_mask = 0xff0000;
+  visual.green_mask = 0x00ff00;
+  visual.blue_mask = 0x0000ff;
+
+  std::vector<uint8_t> data;
+  // Growing the vector between the appends makes GCC 12 warn about a
+  // copy out of bounds at -O2.
+  data.reserve(sizeof(setup) + sizeof(screen) + sizeof(depth) +
+               sizeof(visual));
+  Append(&data, setup);
+  Append(&data, screen);
+  Append(&data, depth);
+  Append(&data, visual);
+  // The length counts the 4-byte units after the first 8 bytes.
+  const auto length = CheckedCast<uint16_t>((data.size() - 8) / 4);
+  std::memcpy(data.data() + offsetof(xcb_setup_t, length), &length,
+              sizeof(length));
+  return data;
+}
+
+}  // namespace
+
+FakeXServer::FakeXServer() : setup_(MakeSetup()), next_atom_(kFirstAtom) {
+  windows_[kRootWindow] = {XCB_WINDOW_NONE, 0, 0, kRootWidth, kRootHeight};
+  try {
+    std::array<int, 2> fds{};
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds.data()) ==
+        -1) {
+      throw PError("socketpair");
+    }
+    server_fd_ = fds[0];
+    client_fd_ = fds[1];
+    if (fcntl(server_fd_, F_SETFL, O_NONBLOCK) == -1) {
+      throw PError("fcntl");
+    }
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ == -1) {
+      throw PError("eventfd");
+    }
+  } catch (...) {
+    Release();
+    throw;
+  }
+  thread_ = std::thread(&FakeXServer::Serve, this);
+}
+
+FakeXServer::~FakeXServer() {
+  stop_ = true;
+  Wake();
+  thread_.join();
+  Release();
+}
+
+void FakeXServer::AddWindow(xcb_window_t window,
+                            xcb_window_t parent,
+                            int16_t x,
+                            int16_t y,
+                            uint16_t width,
+                            uint16_t height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  windows_[window] = {parent, x, y, width, height};
+}
+
+void FakeXServer::SetActiveWindow(xcb_window_t window) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  active_window_ = window;
+}
+
+void FakeXServer::SendEvent(const xcb_generic_event_t& event,
+                            uint64_t count) {
+  PendingEvent pending{{}, count};
+  std::memcpy(pending.event.data(), &event, pending.event.size());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(pending);
+  }
+  Wake();
+}
+
+auto FakeXServer::TakeClientFd() -> int {
+  DCHECK(client_fd_ != -1);
+  return std::exchange(client_fd_, -1);
+}
+
+void FakeXServer::ExpectReply(uint32_t /*sequence*/) {}
+
+void FakeXServer::Release() {
+  for (int fd : {server_fd_, client_fd_, wake_fd_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+void FakeXServer::Wake() {
+  const uint64_t wake = 1;
+  if (write(wake_fd_, &wake, sizeof(wake)) == -1) {
+    perror("write");
+    std::abort();
+  }
+}
+
+void FakeXServer::Serve() {
+  while (!stop_) {
+    bool writing = output_offset_ != output_.size();
+    if (!writing) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      writing = !events_.empty();
+    }
+    std::array<pollfd, 2> fds{{
+        {server_fd_, static_cast<short>(POLLIN | (writing ? POLLOUT : 0)), 0},
+        {wake_fd_, POLLIN, 0},
+    }};
+    if (poll(fds.data(), fds.size(), -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("poll");
+      return;
+    }
+    if (fds[1].revents != 0) {
+      uint64_t wakes;
+      if (read(wake_fd_, &wakes, sizeof(wakes)) == -1 && errno != EAGAIN) {
+        perror("read");
+        return;
+      }
+    }
+    if (fds[0].revents != 0 && !ReadRequests()) {
+      return;
+    }
+    if (setup_sent_) {
+      QueueEvents();
+    }
+    if (!WriteOutput()) {
+      return;
+    }
+  }
+}
+
+auto FakeXServer::ReadRequests() -> bool {
+  std::array<uint8_t, 4096> buffer;
+  while (true) {
+    auto size = read(server_fd_, buffer.data(), buffer.size());
+    if (size > 0) {
+      input_.insert(input_.end(), buffer.begin(), buffer.begin() + size);
+      continue;
+    }
+    if (size == -1 && errno == EINTR) {
+      continue;
+    }
+    if (size == -1 && errno == EAGAIN) {
+      break;
+    }
+    return false;
+  }
+
+  std::size_t offset = 0;
+  if (!setup_sent_) {
+    if (input_.size() < kSetupRequestSize) {
+      return true;
+    }
+    const auto size = kSetupRequestSize +
+                      Pad4(Read<uint16_t>(input_.data() + 6)) +
+                      Pad4(Read<uint16_t>(input_.data() + 8));
+    if (input_.size() < size) {
+      return true;
+    }
+    offset = size;
+    output_.insert(output_.end(), setup_.begin(), setup_.end());
+    setup_sent_ = true;
+  }
+
+  while (input_.size() - offset >= 4) {
+    std::size_t size = std::size_t{Read<uint16_t>(&input_[offset + 2])} * 4;
+    if (size == 0) {
+      // A BIG-REQUESTS request, though that extension is never offered.
+      if (input_.size() - offset < 8) {
+        break;
+      }
+      size = std::size_t{Read<uint32_t>(&input_[offset + 4])} * 4;
+      if (size < 8) {
+        return false;
+      }
+    }
+    if (input_.size() - offset < size) {
+      break;
+    }
+    requests_++;
+    HandleRequest(&input_[offset], size);
+    offset += size;
+  }
+  input_.erase(input_.begin(),
+               input_.begin() + static_cast<std::ptrdiff_t>(offset));
+  return true;
+}
+
+auto FakeXServer::WriteOutput() -> bool {
+  while (output_offset_ < output_.size()) {
+    auto size = send(server_fd_, output_.data() + output_offset_,
+                     output_.size() - output_offset_, MSG_NOSIGNAL);
+    if (size > 0) {
+      output_offset_ += static_cast<std::size_t>(size);
+      continue;
+    }
+    if (size == -1 && errno == EINTR) {
+      continue;
+    }
+    if (size == -1 && errno == EAGAIN) {
+      return true;
+    }
+    return false;
+  }
+  output_.clear();
+  output_offset_ = 0;
+  return true;
+}
+
+void FakeXServer::HandleRequest(const uint8_t* request, std::size_t size) {
+  const uint8_t opcode = request[0];
+  switch (opcode) {
+    case XCB_GET_GEOMETRY: {
+      if (size < 8) {
+        return;
+      }
+      const auto drawable = Read<xcb_drawable_t>(request + 4);
+      if (auto window = FindWindow(drawable, opcode)) {
+        xcb_get_geometry_reply_t reply{};
+        reply.depth = 24;
+        reply.root = kRootWindow;
+        reply.x = window->x;
+        reply.y = window->y;
+        reply.width = window->width;
+        reply.height = window->height;
+        SendReply(reply);
+      }
+      return;
+    }
+    case XCB_QUERY_TREE: {
+      if (size < 8) {
+        return;
+      }
+      const auto window_id = Read<xcb_window_t>(request + 4);
+      if (auto window = FindWindow(window_id, opcode)) {
+        xcb_query_tree_reply_t reply{};
+        reply.root = kRootWindow;
+        reply.parent = window->parent;
+        SendReply(reply);
+      }
+      return;
+    }
+    case XCB_INTERN_ATOM: {
+      if (size < kNamedRequestSize) {
+        return;
+      }
+      const std::size_t name_size = std::min<std::size_t>(
+          Read<uint16_t>(request + 4), size - kNamedRequestSize);
+      xcb_intern_atom_reply_t reply{};
+      reply.atom = InternAtom(std::string(
+          reinterpret_cast<const char*>(request) + kNamedRequestSize,
+          name_size));
+      SendReply(reply);
+      return;
+    }
+    case XCB_GET_PROPERTY: {
+      if (size < kGetPropertySize) {
+        return;
+      }
+      const auto window = Read<xcb_window_t>(request + 4);
+      const auto property = Read<xcb_atom_t>(request + 8);
+      xcb_get_property_reply_t reply{};
+      uint32_t value = 0;
+      if (window == kRootWindow &&
+          property == InternAtom("_NET_SUPPORTED")) {
+        reply.type = XCB_ATOM_ATOM;
+        value = InternAtom("_NET_ACTIVE_WINDOW");
+      } else if (window == kRootWindow &&
+                 property == InternAtom("_NET_ACTIVE_WINDOW")) {
+        reply.type = XCB_ATOM_WINDOW;
+        std::lock_guard<std::mutex> lock(mutex_);
+        value = active_window_;
+      } else {
+        // The property does not exist.
+        SendReply(reply);
+        return;
+      }
+      reply.format = 32;
+      reply.value_len = 1;
+      SendReply(reply, &value, sizeof(value));
+      return;
+    }
+    case XCB_GET_INPUT_FOCUS: {
+      // XCB sends this to sync after many requests without replies.
+      xcb_get_input_focus_reply_t reply{};
+      reply.focus = kRootWindow;
+      SendReply(reply);
+      return;
+    }
+    case XCB_QUERY_EXTENSION: {
+      if (size < kNamedRequestSize) {
+        return;
+      }
+      const std::size_t name_size = std::min<std::size_t>(
+          Read<uint16_t>(request + 4), size - kNamedRequestSize);
+      const std::string name(
+          reinterpret_cast<const char*>(request) + kNamedRequestSize,
+          name_size);
+      xcb_query_extension_reply_t reply{};
+      if (name == "XFIXES") {
+        reply.present = 1;
+        reply.major_opcode = kXFixesOpcode;
+        reply.first_event = 87;
+        reply.first_error = 140;
+      } else if (name == "XInputExtension") {
+        reply.present = 1;
+        reply.major_opcode = kXInputOpcode;
+        reply.first_error = 129;
+      }
+      SendReply(reply);
+      return;
+    }
+    case kXFixesOpcode:
+    case kXInputOpcode:
+      HandleExtensionRequest(request);
+      return;
+    default:
+      return;
+  }
+}
+
+void FakeXServer::HandleExtensionRequest(const uint8_t* request) {
+  const uint8_t minor_opcode = request[1];
+  if (request[0] == kXFixesOpcode &&
+      minor_opcode == XCB_XFIXES_QUERY_VERSION) {
+    xcb_xfixes_query_version_reply_t reply{};
+    reply.major_version = XCB_XFIXES_MAJOR_VERSION;
+    reply.minor_version = XCB_XFIXES_MINOR_VERSION;
+    SendReply(reply);
+  } else if (request[0] == kXInputOpcode &&
+             minor_opcode == XCB_INPUT_XI_QUERY_VERSION) {
+    xcb_input_xi_query_version_reply_t reply{};
+    reply.major_version = XCB_INPUT_MAJOR_VERSION;
+    reply.minor_version = XCB_INPUT_MINOR_VERSION;
+    SendReply(reply);
+  }
+}
+
+auto FakeXServer::FindWindow(xcb_window_t window, uint8_t major_opcode)
+    -> std::optional<Window> {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = windows_.find(window);
+    if (it != windows_.end()) {
+      return it->second;
+    }
+  }
+  SendError(XCB_WINDOW, window, major_opcode);
+  return std::nullopt;
+}
+
+auto FakeXServer::InternAtom(const std::string& name) -> xcb_atom_t {
+  auto [it, inserted] = atoms_.try_emplace(name, next_atom_);
+  if (inserted) {
+    next_atom_++;
+  }
+  return it->second;
+}
+
+template <typename Reply>
+void FakeXServer::SendReply(const Reply& reply,
+                            const void* data,
+                            std::size_t data_size) {
+  static_assert(sizeof(Reply) <= kPacketSize);
+  DCHECK(data_size % 4 == 0);
+  std::array<uint8_t, kPacketSize> packet{};
+  std::memcpy(packet.data(), &reply, sizeof(reply));
+  packet[0] = kReplyType;
+  const auto sequence = static_cast<uint16_t>(requests_);
+  std::memcpy(packet.data() + 2, &sequence, sizeof(sequence));
+  const auto length = CheckedCast<uint32_t>(data_size / 4);
+  std::memcpy(packet.data() + 4, &length, sizeof(length));
+  output_.insert(output_.end(), packet.begin(), packet.end());
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  output_.insert(output_.end(), bytes, bytes + data_size);
+}
+
+void FakeXServer::SendError(uint8_t error_code,
+                            uint32_t bad_value,
+                            uint8_t major_opcode) {
+  xcb_generic_error_t error{};
+  error.response_type = kErrorType;
+  error.error_code = error_code;
+  error.sequence = static_cast<uint16_t>(requests_);
+  error.resource_id = bad_value;
+  error.major_code = major_opcode;
+  // Leave out XCB's |full_sequence|, which is not sent on the wire.
+  const auto* bytes = reinterpret_cast<const uint8_t*>(&error);
+  output_.insert(output_.end(), bytes, bytes + kPacketSize);
+}
+
+void FakeXServer::QueueEvents() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (!events_.empty() &&
+         output_.size() - output_offset_ < kEventChunkSize) {
+    auto& pending = events_.front();
+    // Events carry the number of the last request processed.
+    const auto sequence = static_cast<uint16_t>(requests_);
+    std::memcpy(pending.event.data() + 2, &sequence, sizeof(sequence));
+    output_.insert(output_.end(), pending.event.begin(), pending.event.end());
+    if (--pending.count == 0) {
+      events_.pop_front();
+    }
+  }
+}
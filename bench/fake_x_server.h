@@ -0,0 +1,165 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "in_process_server.h"
+#include "util.h"
+
+// An X server that serves a synthetic window tree held in memory, so that
+// the client can be benchmarked without a display.  It answers the
+// requests that StartupInfo and WindowGeometryTracker make: QueryTree,
+// GetGeometry, InternAtom, GetProperty of the root window's
+// _NET_SUPPORTED and _NET_ACTIVE_WINDOW, QueryExtension, and the XFIXES
+// and XInput version queries.  Every other request is accepted without a
+// reply.  Events passed to SendEvent() follow the replies to all requests
+// received before them.
+//
+// The server runs on its own thread because the client blocks on replies
+// outside the event loop.
+class FakeXServer : public InProcessServer {
+ public:
+  static constexpr xcb_window_t kRootWindow = 0x100;
+  static constexpr uint16_t kRootWidth = 1920;
+  static constexpr uint16_t kRootHeight = 1080;
+
+  static constexpr uint8_t kXFixesOpcode = 138;
+  static constexpr uint8_t kXInputOpcode = 131;
+
+  // Throws PError if the sockets cannot be created.
+  FakeXServer();
+  ~FakeXServer() override;
+
+  // Adds |window| as a child of |parent|, at (|x|, |y|) relative to it.
+  void AddWindow(xcb_window_t window,
+                 xcb_window_t parent,
+                 int16_t x,
+                 int16_t y,
+                 uint16_t width,
+                 uint16_t height);
+
+  // Sets the value of _NET_ACTIVE_WINDOW, which is None at first.  Does
+  // not send PropertyNotify.
+  void SetActiveWindow(xcb_window_t window);
+
+  // Sends the 32 bytes of |event| |count| times.
+  void SendEvent(const xcb_generic_event_t& event, uint64_t count = 1);
+
+  // Returns the sequence number that an event generated now would carry,
+  // i.e. that of the last request received.
+  [[nodiscard]] auto sequence() const -> uint16_t {
+    return static_cast<uint16_t>(requests_);
+  }
+
+  // InProcessServer:
+  [[nodiscard]] auto TakeClientFd() -> int override;
+  // Replies are sent as soon as their requests arrive, so this does
+  // nothing.
+  void ExpectReply(uint32_t sequence) override;
+
+ private:
+  struct Window {
+    xcb_window_t parent;
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+  };
+
+  struct PendingEvent {
+    // xcb_generic_event_t has XCB's |full_sequence| appended, so it is
+    // longer than an event on the wire.
+    std::array<uint8_t, 32> event;
+    uint64_t count;
+  };
+
+  void Serve();
+
+  // Closes the descriptors.
+  void Release();
+
+  void Wake();
+
+  // Returns false once the client has disconnected.
+  auto ReadRequests() -> bool;
+  auto WriteOutput() -> bool;
+
+  void HandleRequest(const uint8_t* request, std::size_t size);
+  void HandleExtensionRequest(const uint8_t* request);
+
+  // Returns the window's entry, or nullopt after sending a BadWindow
+  // error.
+  auto FindWindow(xcb_window_t window, uint8_t major_opcode)
+      -> std::optional<Window>;
+
+  auto InternAtom(const std::string& name) -> xcb_atom_t;
+
+  // Sends the reply to the current request.  |data| follows the fixed
+  // 32-byte part and must be a multiple of 4 bytes long.
+  template <typename Reply>
+  void SendReply(const Reply& reply, const void* data = nullptr,
+                 std::size_t data_size = 0);
+  void SendError(uint8_t error_code, uint32_t bad_value, uint8_t major_opcode);
+
+  // Moves events from |events_| to |output_| until enough are buffered
+  // to keep the socket busy.
+  void QueueEvents();
+
+  std::vector<uint8_t> setup_;
+
+  int server_fd_ = -1;
+  int client_fd_ = -1;
+  int wake_fd_ = -1;
+
+  // Only used by the server thread.
+  std::vector<uint8_t> input_;
+  std::vector<uint8_t> output_;
+  std::size_t output_offset_ = 0;
+  bool setup_sent_ = false;
+  std::unordered_map<std::string, xcb_atom_t> atoms_;
+  xcb_atom_t next_atom_;
+
+  // Shared with the client thread.
+  std::mutex mutex_;
+  std::unordered_map<xcb_window_t, Window> windows_;
+  xcb_window_t active_window_ = XCB_WINDOW_NONE;
+  std::deque<PendingEvent> events_;
+
+  // Written only by the server thread.
+  std::atomic<uint32_t> requests_ = 0;
+
+  std::atomic<bool> stop_ = false;
+
+  std::thread thread_;
+
+  DELETE_SPECIAL_MEMBERS(FakeXServer);
+};
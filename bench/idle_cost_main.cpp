@@ -0,0 +1,333 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+// Measures what the indicator costs when it has nothing to do, which
+// matters more than its peak speed when many instances share a host: its
+// resident memory, context switches and wakeups per second while idle,
+// and its CPU time and wakeups per keystroke of a key it ignores.  The
+// results are compared with ceilings stored in a baseline file, and the
+// run fails if any is exceeded.
+
+#include <getopt.h>
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+#include <xcb/xtest.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>  // IWYU pragma: keep (https://github.com/include-what-you-use/include-what-you-use/issues/277)
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "border_watcher.h"
+#include "child_process.h"
+#include "lippincott.h"
+#include "process_stats.h"
+#include "stand_in_wm.h"
+#include "x_error.h"
+#include "xvfb.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint16_t kScreenWidth = 1920;
+constexpr uint16_t kScreenHeight = 1080;
+constexpr xcb_rectangle_t kClient{200, 200, 640, 480};
+
+// The A key, which the indicator ignores.
+constexpr uint8_t kUnrelatedKeycode = 38;
+
+constexpr std::chrono::milliseconds kStartupTimeout{10000};
+
+// Lets the indicator finish its startup before measuring, and process
+// the last keystrokes before reading its statistics.
+constexpr std::chrono::milliseconds kSettleTime{1000};
+
+// A new baseline allows this much more than the run that wrote it, plus
+// the slack of each measurement, so that noise does not fail runs.
+constexpr double kBaselineHeadroom = 1.25;
+
+constexpr int kBaselineExceeded = 2;
+
+const char* k_usage_message = R"(
+usage: xawi-idle-cost [-h] [-t SECONDS] [-k N] [-r HZ] [-b FILE] [-w FILE]
+                      [-i PATH] [-- INDICATOR_ARGS...]
+
+Measures the indicator's idle cost and its cost per unrelated keystroke
+under Xvfb, which must be in $PATH, and exits with status 2 if any
+measurement exceeds its baseline
+
+optional arguments:
+  -h, --help               show this help message and exit
+  -t, --idle-time SECONDS  how long to measure the idle indicator;
+                           default 10
+  -k, --keystrokes N       unrelated keystrokes to type; default 1000
+  -r, --typing-rate HZ     keystrokes per second; default 50
+  -b, --baseline FILE      ceilings to compare with; default the
+                           idle_cost_baseline.txt this was built with
+  -w, --write-baseline FILE
+                           write ceilings derived from this run to FILE
+                           instead of comparing
+  -i, --indicator PATH     indicator binary; default
+                           x-active-window-indicator next to this binary
+)";
+
+struct Options {
+  double idle_time = 10;
+  uint64_t keystrokes = 1000;
+  double typing_rate = 50;
+  std::string baseline = XAWI_IDLE_COST_BASELINE;
+  std::string write_baseline;
+  std::string indicator;
+  std::vector<std::string> indicator_args;
+};
+
+struct Measurement {
+  const char* name;
+  const char* description;
+  // Added to the measured value when writing a baseline.
+  double slack;
+  double value = 0;
+};
+
+// Returns false if the program should exit after printing the usage.
+auto ParseOptions(int argc, char** argv, Options* options) -> bool {
+  options->indicator = SiblingExecutablePath("x-active-window-indicator");
+  constexpr std::array<struct option, 8> kLongOptions{{
+      {"help", no_argument, nullptr, 'h'},
+      {"idle-time", required_argument, nullptr, 't'},
+      {"keystrokes", required_argument, nullptr, 'k'},
+      {"typing-rate", required_argument, nullptr, 'r'},
+      {"baseline", required_argument, nullptr, 'b'},
+      {"write-baseline", required_argument, nullptr, 'w'},
+      {"indicator", required_argument, nullptr, 'i'},
+      {nullptr, 0, nullptr, 0},
+  }};
+  while (true) {
+    int c = getopt_long(argc, argv, "ht:k:r:b:w:i:", kLongOptions.data(),
+                        nullptr);
+    if (c == -1) {
+      break;
+    }
+    switch (c) {
+      case 't':
+        options->idle_time = std::stod(optarg);
+        break;
+      case 'k':
+        options->keystrokes = std::stoull(optarg);
+        break;
+      case 'r':
+        options->typing_rate = std::stod(optarg);
+        break;
+      case 'b':
+        options->baseline = optarg;
+        break;
+      case 'w':
+        options->write_baseline = optarg;
+        break;
+      case 'i':
+        options->indicator = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+  options->indicator_args.assign(argv + optind, argv + argc);
+  return options->idle_time > 0 && options->keystrokes > 0 &&
+         options->typing_rate > 0;
+}
+
+auto ToSeconds(Clock::duration duration) -> double {
+  return std::chrono::duration<double>(duration).count();
+}
+
+// Reads "name value" lines, skipping blank lines and # comments.
+auto ReadBaseline(const std::string& path) -> std::map<std::string, double> {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Could not read baseline " + path);
+  }
+  std::map<std::string, double> baseline;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    std::string name;
+    double value = 0;
+    if (!(fields >> name >> value)) {
+      throw std::runtime_error("Malformed baseline line: " + line);
+    }
+    baseline[name] = value;
+  }
+  return baseline;
+}
+
+void WriteBaseline(const std::string& path,
+                   const std::vector<Measurement>& measurements) {
+  std::ofstream file(path);
+  file << "# Ceilings for xawi-idle-cost, written by xawi-idle-cost -w.\n";
+  for (const auto& measurement : measurements) {
+    const double ceiling =
+        measurement.value * kBaselineHeadroom + measurement.slack;
+    file << "\n# " << measurement.description << '\n'
+         << measurement.name << ' ' << std::ceil(ceiling * 10) / 10 << '\n';
+  }
+  if (!file) {
+    throw std::runtime_error("Could not write baseline " + path);
+  }
+}
+
+// Returns false if any measurement exceeds its ceiling in |baseline|.
+// Measurements without a ceiling are only reported.
+auto CheckBaseline(std::ostream& stream,
+                   const std::vector<Measurement>& measurements,
+                   const std::map<std::string, double>& baseline) -> bool {
+  bool ok = true;
+  stream << std::fixed << std::setprecision(2);
+  for (const auto& measurement : measurements) {
+    stream << measurement.description << ": " << measurement.value;
+    auto it = baseline.find(measurement.name);
+    if (it != baseline.end()) {
+      const bool exceeded = measurement.value > it->second;
+      stream << " (baseline " << it->second
+             << (exceeded ? ", EXCEEDED)" : ")");
+      ok = ok && !exceeded;
+    }
+    stream << '\n';
+  }
+  stream << std::flush;
+  return ok;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) noexcept -> int {
+  try {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+      std::cerr << k_usage_message << std::endl;
+      return 1;
+    }
+    // Fail on a bad baseline before spending the time to measure.
+    const auto baseline = options.write_baseline.empty()
+                              ? ReadBaseline(options.baseline)
+                              : std::map<std::string, double>{};
+
+    Xvfb xvfb(kScreenWidth, kScreenHeight);
+    std::unique_ptr<xcb_connection_t, decltype(&xcb_disconnect)> connection(
+        xcb_connect(xvfb.display().c_str(), nullptr), &xcb_disconnect);
+    if (xcb_connection_has_error(connection.get()) != 0) {
+      throw XError("Could not connect to " + xvfb.display());
+    }
+    auto* c = connection.get();
+
+    // The keystrokes go to the focused client, which does not select
+    // them, so they reach the root window as they would from a terminal.
+    StandInWm wm(c);
+    wm.Activate(wm.CreateClient(kClient));
+    BorderWatcher watcher(c, wm.root());
+
+    std::vector<std::string> indicator_argv{options.indicator};
+    indicator_argv.insert(indicator_argv.end(),
+                          options.indicator_args.begin(),
+                          options.indicator_args.end());
+    ChildProcess indicator(indicator_argv, {"DISPLAY=" + xvfb.display()});
+    watcher.WaitUntil(
+        [](const BorderWatcher::State& state) { return state.created; },
+        kStartupTimeout);
+    std::this_thread::sleep_for(kSettleTime);
+
+    const auto idle_start = Clock::now();
+    const auto idle_before = ProcessStats::Read(indicator.pid());
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(options.idle_time));
+    const auto idle_after = ProcessStats::Read(indicator.pid());
+    const double idle_seconds = ToSeconds(Clock::now() - idle_start);
+
+    const auto typing_before = ProcessStats::Read(indicator.pid());
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1 / options.typing_rate));
+    auto next = Clock::now();
+    for (uint64_t i = 0; i < options.keystrokes; i++) {
+      for (uint8_t type : {uint8_t{XCB_KEY_PRESS}, uint8_t{XCB_KEY_RELEASE}}) {
+        xcb_test_fake_input(c, type, kUnrelatedKeycode, XCB_CURRENT_TIME,
+                            XCB_WINDOW_NONE, 0, 0, 0);
+      }
+      xcb_flush(c);
+      next += interval;
+      std::this_thread::sleep_until(next);
+    }
+    std::this_thread::sleep_for(kSettleTime);
+    const auto typing_after = ProcessStats::Read(indicator.pid());
+    if (!indicator.Running()) {
+      throw std::runtime_error("The indicator exited during the run");
+    }
+
+    const auto keystrokes = static_cast<double>(options.keystrokes);
+    std::vector<Measurement> measurements{
+        {"rss_kib", "idle resident memory (KiB)", 1024,
+         static_cast<double>(idle_after.rss_bytes) / 1024},
+        {"context_switches_per_second", "idle context switches per second",
+         0.5,
+         static_cast<double>(idle_after.voluntary_context_switches +
+                             idle_after.involuntary_context_switches -
+                             idle_before.voluntary_context_switches -
+                             idle_before.involuntary_context_switches) /
+             idle_seconds},
+        {"wakeups_per_second", "idle wakeups per second", 0.5,
+         static_cast<double>(idle_after.voluntary_context_switches -
+                             idle_before.voluntary_context_switches) /
+             idle_seconds},
+        {"cpu_us_per_keystroke", "CPU time per unrelated keystroke (us)", 20,
+         std::chrono::duration<double, std::micro>(typing_after.cpu_time -
+                                                   typing_before.cpu_time)
+                 .count() /
+             keystrokes},
+        {"wakeups_per_keystroke", "wakeups per unrelated keystroke", 0.5,
+         static_cast<double>(typing_after.voluntary_context_switches -
+                             typing_before.voluntary_context_switches) /
+             keystrokes},
+    };
+
+    if (!options.write_baseline.empty()) {
+      WriteBaseline(options.write_baseline, measurements);
+      CheckBaseline(std::cout, measurements, {});
+      return 0;
+    }
+    if (!CheckBaseline(std::cout, measurements, baseline)) {
+      std::cerr << "Exceeded the baseline in " << options.baseline
+                << std::endl;
+      return kBaselineExceeded;
+    }
+  } catch (...) {
+    Lippincott();
+    return 1;
+  }
+  return 0;
+}
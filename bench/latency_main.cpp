@@ -0,0 +1,205 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+// Measures how long the indicator takes to react, as the user sees it:
+// from a key press to the border being shown around the active window,
+// from a focus change to the border being moved, and from the key
+// release to the border being hidden.  The indicator runs against Xvfb
+// with a stand-in window manager, and keys are injected with XTEST.
+
+#include <getopt.h>
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+#include <xcb/xtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "border_watcher.h"
+#include "child_process.h"
+#include "latency_samples.h"
+#include "lippincott.h"
+#include "stand_in_wm.h"
+#include "x_error.h"
+#include "xvfb.h"
+
+namespace {
+
+constexpr uint16_t kScreenWidth = 1920;
+constexpr uint16_t kScreenHeight = 1080;
+
+// The left Super key, which KeyListener listens for.
+constexpr uint8_t kSuperKeycode = 133;
+
+constexpr uint64_t kDefaultIterations = 1000;
+
+// Generous enough for the indicator's startup and the first round trips.
+constexpr std::chrono::milliseconds kStartupTimeout{10000};
+constexpr std::chrono::milliseconds kTimeout{2000};
+
+constexpr std::array<xcb_rectangle_t, 2> kClients{{
+    {100, 100, 640, 480},
+    {900, 300, 800, 600},
+}};
+
+const char* k_usage_message = R"(
+usage: x-active-window-indicator-latency [-h] [-n N] [-i PATH]
+                                         [-- INDICATOR_ARGS...]
+
+Measures the indicator's key-to-border and focus-to-border latency under
+Xvfb, which must be in $PATH
+
+optional arguments:
+  -h, --help            show this help message and exit
+  -n, --iterations N    number of press, focus change, release rounds;
+                        default 1000
+  -i, --indicator PATH  indicator binary; default x-active-window-indicator
+                        next to this binary
+)";
+
+struct Options {
+  uint64_t iterations = kDefaultIterations;
+  std::string indicator;
+  std::vector<std::string> indicator_args;
+};
+
+// Returns false if the program should exit after printing the usage.
+auto ParseOptions(int argc, char** argv, Options* options) -> bool {
+  options->indicator = SiblingExecutablePath("x-active-window-indicator");
+  constexpr std::array<struct option, 4> kLongOptions{{
+      {"help", no_argument, nullptr, 'h'},
+      {"iterations", required_argument, nullptr, 'n'},
+      {"indicator", required_argument, nullptr, 'i'},
+      {nullptr, 0, nullptr, 0},
+  }};
+  while (true) {
+    int c = getopt_long(argc, argv, "hn:i:", kLongOptions.data(), nullptr);
+    if (c == -1) {
+      break;
+    }
+    switch (c) {
+      case 'n':
+        options->iterations = std::stoull(optarg);
+        break;
+      case 'i':
+        options->indicator = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+  options->indicator_args.assign(argv + optind, argv + argc);
+  return true;
+}
+
+void FakeKey(xcb_connection_t* connection, uint8_t type, uint8_t keycode) {
+  xcb_test_fake_input(connection, type, keycode, XCB_CURRENT_TIME,
+                      XCB_WINDOW_NONE, 0, 0, 0);
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) noexcept -> int {
+  try {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+      std::cerr << k_usage_message << std::endl;
+      return 1;
+    }
+
+    Xvfb xvfb(kScreenWidth, kScreenHeight);
+    std::unique_ptr<xcb_connection_t, decltype(&xcb_disconnect)> connection(
+        xcb_connect(xvfb.display().c_str(), nullptr), &xcb_disconnect);
+    if (xcb_connection_has_error(connection.get()) != 0) {
+      throw XError("Could not connect to " + xvfb.display());
+    }
+    auto* c = connection.get();
+
+    StandInWm wm(c);
+    std::array<xcb_window_t, kClients.size()> clients{};
+    for (std::size_t i = 0; i < kClients.size(); i++) {
+      clients[i] = wm.CreateClient(kClients[i]);
+    }
+    wm.Activate(clients[0]);
+    BorderWatcher watcher(c, wm.root());
+
+    std::vector<std::string> indicator_argv{options.indicator};
+    indicator_argv.insert(indicator_argv.end(),
+                          options.indicator_args.begin(),
+                          options.indicator_args.end());
+    ChildProcess indicator(indicator_argv, {"DISPLAY=" + xvfb.display()});
+    watcher.WaitUntil(
+        [](const BorderWatcher::State& state) { return state.created; },
+        kStartupTimeout);
+
+    LatencySamples shown("key press to border shown");
+    LatencySamples moved("focus change to border moved");
+    LatencySamples hidden("key release to border hidden");
+    // The first round is a warm-up: it also waits out the rest of the
+    // indicator's startup, such as selecting key events.
+    for (uint64_t i = 0; i <= options.iterations; i++) {
+      const bool warm_up = i == 0;
+      const auto timeout = warm_up ? kStartupTimeout : kTimeout;
+      const std::size_t from = i % kClients.size();
+      const std::size_t to = (i + 1) % kClients.size();
+
+      auto start = BorderWatcher::Clock::now();
+      FakeKey(c, XCB_KEY_PRESS, kSuperKeycode);
+      auto end = watcher.WaitUntil(
+          [&](const BorderWatcher::State& state) {
+            return BorderWatcher::Covers(state, kClients[from]);
+          },
+          timeout);
+      if (!warm_up) {
+        shown.Record(end - start);
+      }
+
+      start = BorderWatcher::Clock::now();
+      wm.Activate(clients[to]);
+      end = watcher.WaitUntil(
+          [&](const BorderWatcher::State& state) {
+            return BorderWatcher::Covers(state, kClients[to]);
+          },
+          timeout);
+      if (!warm_up) {
+        moved.Record(end - start);
+      }
+
+      start = BorderWatcher::Clock::now();
+      FakeKey(c, XCB_KEY_RELEASE, kSuperKeycode);
+      end = watcher.WaitUntil(
+          [](const BorderWatcher::State& state) { return !state.mapped; },
+          timeout);
+      if (!warm_up) {
+        hidden.Record(end - start);
+      }
+    }
+
+    for (const auto* samples : {&shown, &moved, &hidden}) {
+      samples->Print(std::cout);
+    }
+  } catch (...) {
+    Lippincott();
+    return 1;
+  }
+  return 0;
+}
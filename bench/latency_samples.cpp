@@ -0,0 +1,65 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "latency_samples.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+namespace {
+
+auto ToMicroseconds(std::chrono::nanoseconds duration) -> double {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+}  // namespace
+
+LatencySamples::LatencySamples(std::string name) : name_(std::move(name)) {}
+
+LatencySamples::~LatencySamples() = default;
+
+void LatencySamples::Record(std::chrono::nanoseconds latency) {
+  samples_.push_back(latency);
+  sorted_ = false;
+}
+
+auto LatencySamples::Quantile(double q) const -> std::chrono::nanoseconds {
+  if (samples_.empty()) {
+    return std::chrono::nanoseconds{0};
+  }
+  if (!sorted_) {
+    sorted_samples_ = samples_;
+    std::sort(sorted_samples_.begin(), sorted_samples_.end());
+    sorted_ = true;
+  }
+  const auto rank = static_cast<std::size_t>(
+      std::ceil(q * static_cast<double>(sorted_samples_.size())));
+  return sorted_samples_[std::clamp<std::size_t>(rank, 1,
+                                                 sorted_samples_.size()) -
+                         1];
+}
+
+void LatencySamples::Print(std::ostream& stream) const {
+  stream << name_ << ": n=" << count() << std::fixed << std::setprecision(1)
+         << " p50=" << ToMicroseconds(Quantile(0.5))
+         << " us p99=" << ToMicroseconds(Quantile(0.99))
+         << " us p99.9=" << ToMicroseconds(Quantile(0.999))
+         << " us max=" << ToMicroseconds(Quantile(1)) << " us" << std::endl;
+}
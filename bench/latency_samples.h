@@ -0,0 +1,54 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+// Every latency recorded for one kind of operation, so that percentiles
+// are exact rather than bucketed like Histogram's.
+class LatencySamples {
+ public:
+  explicit LatencySamples(std::string name);
+  ~LatencySamples();
+
+  void Record(std::chrono::nanoseconds latency);
+
+  // Returns the nearest-rank |q| quantile, or 0 if nothing was recorded.
+  [[nodiscard]] auto Quantile(double q) const -> std::chrono::nanoseconds;
+
+  [[nodiscard]] auto name() const -> const std::string& { return name_; }
+  [[nodiscard]] auto count() const -> std::size_t { return samples_.size(); }
+
+  // Prints the count and the p50, p99, p99.9 and maximum latencies.
+  void Print(std::ostream& stream) const;
+
+ private:
+  std::string name_;
+  std::vector<std::chrono::nanoseconds> samples_;
+  // |samples_| in order, updated by Quantile() when |sorted_| is false.
+  mutable bool sorted_ = true;
+  mutable std::vector<std::chrono::nanoseconds> sorted_samples_;
+
+  DELETE_SPECIAL_MEMBERS(LatencySamples);
+};
@@ -0,0 +1,462 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+// Runs the indicator against Xvfb under synthetic window manager load:
+// many reparented clients, focus changes, drags of the active window and
+// churn of a root window property that the indicator must ignore.  Super
+// is held throughout so that the indicator tracks the active window, and
+// the time from each focus change or move to the border following it is
+// reported, along with the CPU time the indicator and the X server used.
+
+#include <getopt.h>
+#include <poll.h>
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+#include <xcb/xtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "border_watcher.h"
+#include "child_process.h"
+#include "latency_samples.h"
+#include "lippincott.h"
+#include "p_error.h"
+#include "process_stats.h"
+#include "stand_in_wm.h"
+#include "x_error.h"
+#include "xvfb.h"
+
+namespace {
+
+using Clock = BorderWatcher::Clock;
+
+constexpr uint16_t kScreenWidth = 1920;
+constexpr uint16_t kScreenHeight = 1080;
+constexpr uint16_t kClientWidth = 400;
+constexpr uint16_t kClientHeight = 300;
+
+// The left Super key, which KeyListener listens for.
+constexpr uint8_t kSuperKeycode = 133;
+
+constexpr std::chrono::milliseconds kStartupTimeout{10000};
+
+// Positions the border has not reached after this long once the load
+// stops are reported as never reached.
+constexpr std::chrono::milliseconds kDrainTime{1000};
+
+// A load that falls further behind its schedule than this skips the
+// missed runs instead of bursting to catch up.
+constexpr std::chrono::milliseconds kMaxLag{1000};
+
+// Bounds the positions awaited from the border if it falls behind.
+constexpr std::size_t kMaxExpectations = 100000;
+
+const char* k_usage_message = R"(
+usage: xawi-loadgen [-h] [-w N] [-d DEPTH] [-f HZ] [-g HZ] [-p HZ]
+                    [-t SECONDS] [-i PATH] [-- INDICATOR_ARGS...]
+
+Runs the indicator against Xvfb, which must be in $PATH, under synthetic
+window manager load, and reports how closely the border follows
+
+optional arguments:
+  -h, --help              show this help message and exit
+  -w, --windows N         number of client windows; default 100
+  -d, --depth DEPTH       frames each client is reparented into; default 2
+  -f, --focus-rate HZ     active window changes per second; default 10
+  -g, --drag-rate HZ      moves of the active window per second; default 60
+  -p, --property-rate HZ  changes of an unrelated root window property per
+                          second; default 100
+  -t, --duration SECONDS  how long to apply the load; default 10
+  -i, --indicator PATH    indicator binary; default x-active-window-indicator
+                          next to this binary
+)";
+
+struct Options {
+  uint32_t windows = 100;
+  uint32_t depth = 2;
+  double focus_rate = 10;
+  double drag_rate = 60;
+  double property_rate = 100;
+  double duration = 10;
+  std::string indicator;
+  std::vector<std::string> indicator_args;
+};
+
+// Returns false if the program should exit after printing the usage.
+auto ParseOptions(int argc, char** argv, Options* options) -> bool {
+  options->indicator = SiblingExecutablePath("x-active-window-indicator");
+  constexpr std::array<struct option, 9> kLongOptions{{
+      {"help", no_argument, nullptr, 'h'},
+      {"windows", required_argument, nullptr, 'w'},
+      {"depth", required_argument, nullptr, 'd'},
+      {"focus-rate", required_argument, nullptr, 'f'},
+      {"drag-rate", required_argument, nullptr, 'g'},
+      {"property-rate", required_argument, nullptr, 'p'},
+      {"duration", required_argument, nullptr, 't'},
+      {"indicator", required_argument, nullptr, 'i'},
+      {nullptr, 0, nullptr, 0},
+  }};
+  while (true) {
+    int c = getopt_long(argc, argv, "hw:d:f:g:p:t:i:", kLongOptions.data(),
+                        nullptr);
+    if (c == -1) {
+      break;
+    }
+    switch (c) {
+      case 'w':
+        options->windows = CheckedCast<uint32_t>(std::stoul(optarg));
+        break;
+      case 'd':
+        options->depth = CheckedCast<uint32_t>(std::stoul(optarg));
+        break;
+      case 'f':
+        options->focus_rate = std::stod(optarg);
+        break;
+      case 'g':
+        options->drag_rate = std::stod(optarg);
+        break;
+      case 'p':
+        options->property_rate = std::stod(optarg);
+        break;
+      case 't':
+        options->duration = std::stod(optarg);
+        break;
+      case 'i':
+        options->indicator = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+  options->indicator_args.assign(argv + optind, argv + argc);
+  return options->windows > 0;
+}
+
+auto ToSeconds(Clock::duration duration) -> double {
+  return std::chrono::duration<double>(duration).count();
+}
+
+// Runs a task |rate| times per second.
+class PeriodicLoad {
+ public:
+  PeriodicLoad(std::string name,
+               double rate,
+               Clock::time_point start,
+               std::function<void()> task)
+      : name_(std::move(name)),
+        period_(rate > 0 ? std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double>(1 / rate))
+                         : Clock::duration::zero()),
+        next_(start),
+        task_(std::move(task)) {}
+
+  [[nodiscard]] auto enabled() const -> bool {
+    return period_ != Clock::duration::zero();
+  }
+  [[nodiscard]] auto next() const -> Clock::time_point { return next_; }
+
+  // Runs the task once for every period that has started by |now|.
+  void RunDue(Clock::time_point now) {
+    if (!enabled()) {
+      return;
+    }
+    if (now - next_ > kMaxLag) {
+      const auto skipped = (now - next_) / period_;
+      missed_ += static_cast<uint64_t>(skipped);
+      next_ += skipped * period_;
+    }
+    while (next_ <= now) {
+      task_();
+      runs_++;
+      next_ += period_;
+    }
+  }
+
+  void Print(std::ostream& stream, Clock::duration elapsed) const {
+    if (!enabled()) {
+      return;
+    }
+    stream << name_ << ": " << runs_ << " (" << std::fixed
+           << std::setprecision(1)
+           << static_cast<double>(runs_) / ToSeconds(elapsed) << "/s, "
+           << missed_ << " missed)" << std::endl;
+  }
+
+ private:
+  std::string name_;
+  Clock::duration period_;
+  Clock::time_point next_;
+  std::function<void()> task_;
+  uint64_t runs_ = 0;
+  uint64_t missed_ = 0;
+};
+
+// Times how long the border takes to reach each position the load moves
+// the active window to.  Positions the border skips, because a later one
+// superseded them before the indicator caught up, are only counted.
+class BorderFollower {
+ public:
+  BorderFollower() = default;
+
+  void Expect(const xcb_rectangle_t& geometry,
+              Clock::time_point time,
+              LatencySamples* samples) {
+    if (expectations_.size() == kMaxExpectations) {
+      expectations_.pop_front();
+      skipped_++;
+    }
+    expectations_.push_back({geometry, time, samples});
+  }
+
+  void OnBorderChanged(const BorderWatcher::State& state,
+                       Clock::time_point time) {
+    auto it = std::find_if(expectations_.begin(), expectations_.end(),
+                           [&state](const Expectation& expectation) {
+                             return BorderWatcher::Covers(
+                                 state, expectation.geometry);
+                           });
+    if (it == expectations_.end()) {
+      return;
+    }
+    it->samples->Record(time - it->time);
+    skipped_ += static_cast<uint64_t>(it - expectations_.begin());
+    expectations_.erase(expectations_.begin(), it + 1);
+  }
+
+  void Print(std::ostream& stream) const {
+    stream << "border positions skipped: " << skipped_
+           << ", never reached: " << expectations_.size() << std::endl;
+  }
+
+ private:
+  struct Expectation {
+    xcb_rectangle_t geometry;
+    Clock::time_point time;
+    LatencySamples* samples;
+  };
+
+  std::deque<Expectation> expectations_;
+  uint64_t skipped_ = 0;
+};
+
+auto InternAtom(xcb_connection_t* connection, const std::string& name)
+    -> xcb_atom_t {
+  std::unique_ptr<xcb_intern_atom_reply_t, FreeDeleter> reply(
+      xcb_intern_atom_reply(
+          connection,
+          xcb_intern_atom(connection, 0, CheckedCast<uint16_t>(name.size()),
+                          name.c_str()),
+          nullptr));
+  if (!reply) {
+    throw XError("InternAtom " + name + " failed");
+  }
+  return reply->atom;
+}
+
+void PrintCpu(std::ostream& stream,
+              const char* name,
+              const ProcessStats& before,
+              const ProcessStats& after,
+              Clock::duration elapsed) {
+  const auto cpu = after.cpu_time - before.cpu_time;
+  stream << name << " CPU: " << std::fixed << std::setprecision(1)
+         << std::chrono::duration<double, std::milli>(cpu).count() << " ms ("
+         << 100 * ToSeconds(cpu) / ToSeconds(elapsed) << "% of a core)"
+         << std::endl;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) noexcept -> int {
+  try {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+      std::cerr << k_usage_message << std::endl;
+      return 1;
+    }
+
+    Xvfb xvfb(kScreenWidth, kScreenHeight);
+    std::unique_ptr<xcb_connection_t, decltype(&xcb_disconnect)> connection(
+        xcb_connect(xvfb.display().c_str(), nullptr), &xcb_disconnect);
+    if (xcb_connection_has_error(connection.get()) != 0) {
+      throw XError("Could not connect to " + xvfb.display());
+    }
+    auto* c = connection.get();
+
+    StandInWm wm(c, options.depth);
+    std::vector<xcb_window_t> clients;
+    for (uint32_t i = 0; i < options.windows; i++) {
+      clients.push_back(wm.CreateClient(
+          {CheckedCast<int16_t>(50 + i * 37 % (kScreenWidth - 500)),
+           CheckedCast<int16_t>(50 + i * 23 % (kScreenHeight - 400)),
+           kClientWidth, kClientHeight}));
+    }
+    xcb_window_t active = clients.front();
+    wm.Activate(active);
+    const xcb_atom_t churn_atom = InternAtom(c, "_XAWI_LOADGEN_CHURN");
+    BorderWatcher watcher(c, wm.root());
+
+    std::vector<std::string> indicator_argv{options.indicator};
+    indicator_argv.insert(indicator_argv.end(),
+                          options.indicator_args.begin(),
+                          options.indicator_args.end());
+    ChildProcess indicator(indicator_argv, {"DISPLAY=" + xvfb.display()});
+    watcher.WaitUntil(
+        [](const BorderWatcher::State& state) { return state.created; },
+        kStartupTimeout);
+    xcb_test_fake_input(c, XCB_KEY_PRESS, kSuperKeycode, XCB_CURRENT_TIME,
+                        XCB_WINDOW_NONE, 0, 0, 0);
+    watcher.WaitUntil(
+        [&](const BorderWatcher::State& state) {
+          return BorderWatcher::Covers(state, wm.ClientGeometry(active));
+        },
+        kStartupTimeout);
+
+    LatencySamples focus_samples("focus change to border moved");
+    LatencySamples drag_samples("drag to border moved");
+    BorderFollower follower;
+    std::mt19937 random;
+    std::uniform_int_distribution<std::size_t> pick_client(
+        0, clients.size() - 1);
+    int16_t dx = 7;
+    int16_t dy = 5;
+    uint32_t churn = 0;
+
+    const auto start = Clock::now();
+    const auto end =
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(options.duration));
+    const auto indicator_before = ProcessStats::Read(indicator.pid());
+    const auto xvfb_before = ProcessStats::Read(xvfb.pid());
+    std::array<PeriodicLoad, 3> loads{{
+        {"focus changes", options.focus_rate, start,
+         [&]() {
+           active = clients[pick_client(random)];
+           wm.Activate(active);
+           follower.Expect(wm.ClientGeometry(active), Clock::now(),
+                           &focus_samples);
+         }},
+        {"drags", options.drag_rate, start,
+         [&]() {
+           const auto& geometry = wm.ClientGeometry(active);
+           if (geometry.x + dx < 0 ||
+               geometry.x + dx + kClientWidth > kScreenWidth) {
+             dx = CheckedCast<int16_t>(-dx);
+           }
+           if (geometry.y + dy < 0 ||
+               geometry.y + dy + kClientHeight > kScreenHeight) {
+             dy = CheckedCast<int16_t>(-dy);
+           }
+           wm.Move(active, CheckedCast<int16_t>(geometry.x + dx),
+                   CheckedCast<int16_t>(geometry.y + dy));
+           follower.Expect(wm.ClientGeometry(active), Clock::now(),
+                           &drag_samples);
+         }},
+        {"property changes", options.property_rate, start,
+         [&]() {
+           churn++;
+           xcb_change_property(c, XCB_PROP_MODE_REPLACE, wm.root(),
+                               churn_atom, XCB_ATOM_CARDINAL, 32, 1, &churn);
+         }},
+    }};
+
+    const auto on_border_changed = [&follower](
+                                       const BorderWatcher::State& state,
+                                       Clock::time_point time) {
+      follower.OnBorderChanged(state, time);
+    };
+    auto now = start;
+    while (now < end) {
+      auto wake = end;
+      for (const auto& load : loads) {
+        if (load.enabled()) {
+          wake = std::min(wake, load.next());
+        }
+      }
+      xcb_flush(c);
+      const auto timeout =
+          std::chrono::ceil<std::chrono::milliseconds>(wake - now);
+      struct pollfd poll_fd {
+        xcb_get_file_descriptor(c), POLLIN, 0
+      };
+      if (REDO_ON_EINTR(poll(&poll_fd, 1,
+                             CheckedCast<int>(std::max<int64_t>(
+                                 timeout.count(), 0)))) == -1) {
+        throw PError("poll");
+      }
+      watcher.ProcessPendingEvents(on_border_changed);
+      now = Clock::now();
+      for (auto& load : loads) {
+        load.RunDue(std::min(now, end));
+      }
+    }
+    const auto elapsed = Clock::now() - start;
+    const auto indicator_after = ProcessStats::Read(indicator.pid());
+    const auto xvfb_after = ProcessStats::Read(xvfb.pid());
+
+    // Let the border catch up with the last positions.
+    xcb_flush(c);
+    const auto drain_end = Clock::now() + kDrainTime;
+    while (Clock::now() < drain_end) {
+      struct pollfd poll_fd {
+        xcb_get_file_descriptor(c), POLLIN, 0
+      };
+      const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+          drain_end - Clock::now());
+      if (REDO_ON_EINTR(poll(&poll_fd, 1,
+                             CheckedCast<int>(std::max<int64_t>(
+                                 remaining.count(), 0)))) == -1) {
+        throw PError("poll");
+      }
+      watcher.ProcessPendingEvents(on_border_changed);
+    }
+    xcb_test_fake_input(c, XCB_KEY_RELEASE, kSuperKeycode, XCB_CURRENT_TIME,
+                        XCB_WINDOW_NONE, 0, 0, 0);
+    xcb_flush(c);
+
+    std::cout << "Load: " << options.windows << " windows in "
+              << options.depth << " frames each for " << std::fixed
+              << std::setprecision(1) << ToSeconds(elapsed) << " s"
+              << std::endl;
+    for (const auto& load : loads) {
+      load.Print(std::cout, elapsed);
+    }
+    focus_samples.Print(std::cout);
+    drag_samples.Print(std::cout);
+    follower.Print(std::cout);
+    PrintCpu(std::cout, "indicator", indicator_before, indicator_after,
+             elapsed);
+    PrintCpu(std::cout, "Xvfb", xvfb_before, xvfb_after, elapsed);
+  } catch (...) {
+    Lippincott();
+    return 1;
+  }
+  return 0;
+}
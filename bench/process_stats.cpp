@@ -0,0 +1,105 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "process_stats.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace {
+
+// Returns the fields of /proc/|pid|/stat after the command name, which
+// may itself contain spaces.  The first one is field 3, the state.
+auto StatFields(pid_t pid) -> std::istringstream {
+  const std::string path = "/proc/" + std::to_string(pid) + "/stat";
+  std::ifstream file(path);
+  std::string line;
+  if (!std::getline(file, line)) {
+    throw std::runtime_error("Could not read " + path);
+  }
+  return std::istringstream(line.substr(line.rfind(')') + 2));
+}
+
+// Returns the CPU time from /proc/|pid|/stat, which counts clock ticks.
+auto StatCpuTime(pid_t pid) -> std::chrono::nanoseconds {
+  auto fields = StatFields(pid);
+  // Skip to utime and stime, fields 14 and 15.
+  std::string skipped;
+  for (int field = 3; field < 14; field++) {
+    fields >> skipped;
+  }
+  uint64_t utime = 0;
+  uint64_t stime = 0;
+  fields >> utime >> stime;
+  if (fields.fail()) {
+    throw std::runtime_error("Malformed stat of process " +
+                             std::to_string(pid));
+  }
+  const auto ticks_per_second = static_cast<uint64_t>(sysconf(_SC_CLK_TCK));
+  return std::chrono::nanoseconds{(utime + stime) * uint64_t{1000000000} /
+                                  ticks_per_second};
+}
+
+// Returns the value of the line starting with |key| in the status file
+// at |path|, or 0 if there is none.
+auto StatusValue(const std::string& path, const std::string& key)
+    -> uint64_t {
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.compare(0, key.size(), key) == 0) {
+      return std::stoull(line.substr(key.size()));
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+// static
+auto ProcessStats::Read(pid_t pid) -> ProcessStats {
+  const std::string proc = "/proc/" + std::to_string(pid);
+  ProcessStats stats;
+  // Also checks that the process exists.
+  const auto tick_cpu_time = StatCpuTime(pid);
+
+  std::chrono::nanoseconds run_time{0};
+  std::error_code error;
+  for (const auto& task :
+       std::filesystem::directory_iterator(proc + "/task", error)) {
+    // Threads may exit while they are read.
+    std::ifstream schedstat(task.path() / "schedstat");
+    uint64_t task_run_time = 0;
+    if (schedstat >> task_run_time) {
+      run_time += std::chrono::nanoseconds{task_run_time};
+    }
+    const std::string status = task.path() / "status";
+    stats.voluntary_context_switches +=
+        StatusValue(status, "voluntary_ctxt_switches:");
+    stats.involuntary_context_switches +=
+        StatusValue(status, "nonvoluntary_ctxt_switches:");
+  }
+  stats.cpu_time = run_time.count() != 0 ? run_time : tick_cpu_time;
+  stats.rss_bytes = StatusValue(proc + "/status", "VmRSS:") * 1024;
+  return stats;
+}
@@ -0,0 +1,41 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+
+// Resource usage of a process, read from /proc.
+struct ProcessStats {
+  // Throws std::runtime_error if the process does not exist.
+  static auto Read(pid_t pid) -> ProcessStats;
+
+  // User and system CPU time, to the nanosecond where the kernel keeps
+  // scheduler statistics and to the clock tick otherwise.
+  std::chrono::nanoseconds cpu_time{0};
+
+  // Resident set size.
+  uint64_t rss_bytes = 0;
+
+  // Summed over the live threads.  A voluntary switch is a thread
+  // blocking, so each one is followed by a wakeup.
+  uint64_t voluntary_context_switches = 0;
+  uint64_t involuntary_context_switches = 0;
+};
@@ -0,0 +1,176 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "stand_in_wm.h"
+
+#include <array>
+#include <memory>
+#include <utility>
+
+#include "x_error.h"
+
+namespace {
+
+// How far each frame extends past the one inside it, like a title bar
+// and borders would.
+constexpr int16_t kFrameInset = 4;
+
+constexpr uint32_t kClientBackground = 0xffffff;
+constexpr uint32_t kFrameBackground = 0x404040;
+
+}  // namespace
+
+StandInWm::StandInWm(xcb_connection_t* connection, uint32_t frame_depth)
+    : connection_(connection),
+      frame_depth_(frame_depth),
+      root_(xcb_setup_roots_iterator(xcb_get_setup(connection_)).data->root),
+      net_active_window_(InternAtom("_NET_ACTIVE_WINDOW")),
+      check_window_(xcb_generate_id(connection_)) {
+  // The indicator only checks _NET_SUPPORTED, but a real window manager
+  // also proves that it is running with _NET_SUPPORTING_WM_CHECK.
+  const xcb_atom_t supporting_wm_check =
+      InternAtom("_NET_SUPPORTING_WM_CHECK");
+  xcb_create_window(connection_, XCB_COPY_FROM_PARENT, check_window_, root_,
+                    -1, -1, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_ONLY,
+                    XCB_COPY_FROM_PARENT, 0, nullptr);
+  for (xcb_window_t window : {root_, check_window_}) {
+    xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, window,
+                        supporting_wm_check, XCB_ATOM_WINDOW, 32, 1,
+                        &check_window_);
+  }
+  const std::array<xcb_atom_t, 2> supported{net_active_window_,
+                                            supporting_wm_check};
+  xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, root_,
+                      InternAtom("_NET_SUPPORTED"), XCB_ATOM_ATOM, 32,
+                      supported.size(), supported.data());
+  Activate(XCB_WINDOW_NONE);
+  xcb_flush(connection_);
+}
+
+StandInWm::~StandInWm() {
+  xcb_destroy_window(connection_, check_window_);
+  xcb_flush(connection_);
+}
+
+auto StandInWm::CreateClient(const xcb_rectangle_t& geometry)
+    -> xcb_window_t {
+  // Like a real client, the window is created on the root and only then
+  // reparented, so the indicator sees ReparentNotify if it is watching.
+  const xcb_window_t client = xcb_generate_id(connection_);
+  xcb_create_window(connection_, XCB_COPY_FROM_PARENT, client, root_,
+                    geometry.x, geometry.y, geometry.width, geometry.height,
+                    0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                    XCB_CW_BACK_PIXEL, &kClientBackground);
+
+  xcb_window_t parent = root_;
+  std::vector<xcb_window_t> frames;
+  const auto depth = CheckedCast<int16_t>(frame_depth_);
+  for (int16_t level = depth; level > 0; level--) {
+    const xcb_window_t frame = xcb_generate_id(connection_);
+    // The outermost frame is placed in root coordinates, and each frame
+    // inside it is inset from its parent.
+    const int16_t offset =
+        parent == root_ ? -CheckedCast<int16_t>(kFrameInset * level)
+                        : kFrameInset;
+    xcb_create_window(
+        connection_, XCB_COPY_FROM_PARENT, frame, parent,
+        CheckedCast<int16_t>((parent == root_ ? geometry.x : 0) + offset),
+        CheckedCast<int16_t>((parent == root_ ? geometry.y : 0) + offset),
+        CheckedCast<uint16_t>(geometry.width + 2 * kFrameInset * level),
+        CheckedCast<uint16_t>(geometry.height + 2 * kFrameInset * level), 0,
+        XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+        XCB_CW_BACK_PIXEL, &kFrameBackground);
+    xcb_map_window(connection_, frame);
+    frames.push_back(frame);
+    parent = frame;
+  }
+  if (parent != root_) {
+    xcb_reparent_window(connection_, client, parent, kFrameInset,
+                        kFrameInset);
+  }
+  xcb_map_window(connection_, client);
+  const xcb_window_t top_level = frames.empty() ? client : frames.front();
+  clients_[client] = {top_level, geometry, std::move(frames)};
+  return client;
+}
+
+void StandInWm::Activate(xcb_window_t client) {
+  xcb_change_property(connection_, XCB_PROP_MODE_REPLACE, root_,
+                      net_active_window_, XCB_ATOM_WINDOW, 32, 1, &client);
+  xcb_set_input_focus(connection_, XCB_INPUT_FOCUS_POINTER_ROOT,
+                      client == XCB_WINDOW_NONE ? root_ : client,
+                      XCB_CURRENT_TIME);
+}
+
+void StandInWm::Move(xcb_window_t client, int16_t x, int16_t y) {
+  auto& entry = clients_.at(client);
+  entry.geometry.x = x;
+  entry.geometry.y = y;
+  const auto inset = CheckedCast<int16_t>(kFrameInset * frame_depth_);
+  xcb_configure_window_value_list_t configure{};
+  configure.x = x - inset;
+  configure.y = y - inset;
+  xcb_configure_window_aux(connection_, entry.top_level,
+                           XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y,
+                           &configure);
+}
+
+void StandInWm::Resize(xcb_window_t client, uint16_t width, uint16_t height) {
+  auto& entry = clients_.at(client);
+  entry.geometry.width = width;
+  entry.geometry.height = height;
+  auto level = CheckedCast<int32_t>(entry.frames.size());
+  for (xcb_window_t frame : entry.frames) {
+    xcb_configure_window_value_list_t configure{};
+    configure.width = CheckedCast<uint32_t>(width + 2 * kFrameInset * level);
+    configure.height =
+        CheckedCast<uint32_t>(height + 2 * kFrameInset * level);
+    xcb_configure_window_aux(
+        connection_, frame,
+        XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, &configure);
+    level--;
+  }
+  xcb_configure_window_value_list_t configure{};
+  configure.width = width;
+  configure.height = height;
+  xcb_configure_window_aux(connection_, client,
+                           XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+                           &configure);
+}
+
+auto StandInWm::ClientGeometry(xcb_window_t client) const
+    -> const xcb_rectangle_t& {
+  return clients_.at(client).geometry;
+}
+
+auto StandInWm::InternAtom(const std::string& name) -> xcb_atom_t {
+  xcb_generic_error_t* error = nullptr;
+  std::unique_ptr<xcb_intern_atom_reply_t, FreeDeleter> reply(
+      xcb_intern_atom_reply(
+          connection_,
+          xcb_intern_atom(connection_, 0, CheckedCast<uint16_t>(name.size()),
+                          name.c_str()),
+          &error));
+  if (error != nullptr) {
+    std::unique_ptr<xcb_generic_error_t, FreeDeleter> owned_error(error);
+    throw XError(*owned_error);
+  }
+  if (!reply) {
+    throw XError("Connection closed before reply was received");
+  }
+  return reply->atom;
+}
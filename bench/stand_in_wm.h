@@ -0,0 +1,83 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util.h"
+
+// The parts of an EWMH window manager that the indicator relies on: it
+// advertises _NET_ACTIVE_WINDOW in _NET_SUPPORTED, and activating a
+// client sets _NET_ACTIVE_WINDOW and the input focus.  Each client is
+// reparented into |frame_depth| nested frames, as decorating window
+// managers do; with a depth of 0 clients stay top-level windows.
+class StandInWm {
+ public:
+  // Throws XError if the initial requests fail.
+  explicit StandInWm(xcb_connection_t* connection, uint32_t frame_depth = 0);
+  ~StandInWm();
+
+  // Creates and maps a client window without a border, with its frames
+  // around it so that the client itself ends up at |geometry| in root
+  // coordinates.  Does not flush.
+  auto CreateClient(const xcb_rectangle_t& geometry) -> xcb_window_t;
+
+  // Makes |client| the active window.  Does not flush.
+  void Activate(xcb_window_t client);
+
+  // Moves the outermost frame of |client| so that the client ends up at
+  // (|x|, |y|) in root coordinates.  Does not flush.
+  void Move(xcb_window_t client, int16_t x, int16_t y);
+
+  // Resizes |client| and its frames, keeping its position.  Does not
+  // flush.
+  void Resize(xcb_window_t client, uint16_t width, uint16_t height);
+
+  // Returns the geometry of |client| in root coordinates.
+  [[nodiscard]] auto ClientGeometry(xcb_window_t client) const
+      -> const xcb_rectangle_t&;
+
+  [[nodiscard]] auto root() const -> xcb_window_t { return root_; }
+
+ private:
+  struct Client {
+    // The outermost frame, or the client itself without frames.
+    xcb_window_t top_level;
+    xcb_rectangle_t geometry;
+    // Outermost first.
+    std::vector<xcb_window_t> frames;
+  };
+
+  auto InternAtom(const std::string& name) -> xcb_atom_t;
+
+  xcb_connection_t* connection_;
+  uint32_t frame_depth_;
+  xcb_window_t root_;
+  xcb_atom_t net_active_window_;
+  xcb_window_t check_window_;
+
+  std::unordered_map<xcb_window_t, Client> clients_;
+
+  DELETE_SPECIAL_MEMBERS(StandInWm);
+};
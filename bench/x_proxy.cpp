@@ -0,0 +1,326 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "x_proxy.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+
+#include "lippincott.h"
+#include "p_error.h"
+
+namespace {
+
+// Display numbers well above those Xvfb -displayfd and desktop sessions
+// pick, so that probing rarely collides.
+constexpr uint32_t kFirstDisplay = 100;
+constexpr uint32_t kLastDisplay = 999;
+
+constexpr const char* kSocketDirectory = "/tmp/.X11-unix";
+
+auto SocketPath(uint32_t display_number) -> std::string {
+  return std::string(kSocketDirectory) + "/X" +
+         std::to_string(display_number);
+}
+
+auto DisplayName(uint32_t display_number) -> std::string {
+  // Appending rather than writing ":" + std::to_string() avoids a false
+  // -Wrestrict warning from GCC 12 at -O2.
+  std::string name = ":";
+  name += std::to_string(display_number);
+  return name;
+}
+
+auto MakeAddress(const std::string& path) -> sockaddr_un {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument("Socket path too long: " + path);
+  }
+  path.copy(address.sun_path, path.size());
+  return address;
+}
+
+auto MakeSocket() -> int {
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    throw PError("socket");
+  }
+  return fd;
+}
+
+auto MakeEventFd() -> int {
+  int fd = eventfd(0, EFD_CLOEXEC);
+  if (fd == -1) {
+    throw PError("eventfd");
+  }
+  return fd;
+}
+
+// Returns a socket listening on the first free display number, which it
+// stores in |display_number|.
+auto ListenOnFreeDisplay(uint32_t* display_number) -> int {
+  if (mkdir(kSocketDirectory, 01777) == -1 && errno != EEXIST) {
+    throw PError("mkdir");
+  }
+  int fd = MakeSocket();
+  try {
+    for (uint32_t n = kFirstDisplay; n <= kLastDisplay; n++) {
+      // A lock file means a server owns the display even if its socket
+      // is not there yet.
+      struct stat info {};
+      const std::string lock = "/tmp/.X" + std::to_string(n) + "-lock";
+      if (lstat(lock.c_str(), &info) == 0) {
+        continue;
+      }
+      const auto address = MakeAddress(SocketPath(n));
+      if (bind(fd, reinterpret_cast<const sockaddr*>(&address),
+               sizeof(address)) == -1) {
+        if (errno == EADDRINUSE) {
+          continue;
+        }
+        throw PError("bind");
+      }
+      if (listen(fd, 1) == -1) {
+        unlink(address.sun_path);
+        throw PError("listen");
+      }
+      *display_number = n;
+      return fd;
+    }
+    throw std::runtime_error("No free display number for the proxy");
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+}
+
+auto ReadBig16(const uint8_t* data) -> uint32_t {
+  return static_cast<uint32_t>(data[0] << 8 | data[1]);
+}
+
+auto ReadLittle16(const uint8_t* data) -> uint32_t {
+  return static_cast<uint32_t>(data[1] << 8 | data[0]);
+}
+
+// Splits the byte stream a client sends into its connection setup and
+// requests, and counts the requests.
+class RequestParser {
+ public:
+  RequestParser() = default;
+  ~RequestParser() = default;
+
+  // Returns the number of requests whose header is completed by |data|.
+  // Throws std::runtime_error if the stream is malformed.
+  auto Feed(const uint8_t* data, std::size_t size) -> uint64_t {
+    uint64_t requests = 0;
+    while (size > 0) {
+      if (skip_ > 0) {
+        const auto n = std::min<uint64_t>(skip_, size);
+        data += n;
+        size -= n;
+        skip_ -= n;
+        continue;
+      }
+      const std::size_t needed = HeaderSize();
+      const std::size_t n = std::min(needed - header_size_, size);
+      std::copy_n(data, n, header_.begin() + header_size_);
+      header_size_ += n;
+      data += n;
+      size -= n;
+      if (header_size_ < HeaderSize()) {
+        continue;
+      }
+      if (!setup_done_) {
+        // The setup request is followed by the authorization protocol
+        // name and data, each padded to 4 bytes.
+        big_endian_ = header_[0] == 'B';
+        skip_ = Pad(Read16(6)) + Pad(Read16(8));
+        setup_done_ = true;
+      } else {
+        uint64_t length = Read16(2);
+        if (length == 0) {
+          // BIG-REQUESTS puts a 32 bit length after the header.
+          length = Read16(big_endian_ ? 4 : 6) << 16 |
+                   Read16(big_endian_ ? 6 : 4);
+        }
+        if (length * 4 < header_size_) {
+          throw std::runtime_error("Malformed request length");
+        }
+        skip_ = length * 4 - header_size_;
+        requests++;
+      }
+      header_size_ = 0;
+    }
+    return requests;
+  }
+
+ private:
+  static constexpr std::size_t kSetupHeaderSize = 12;
+  static constexpr std::size_t kRequestHeaderSize = 4;
+  static constexpr std::size_t kBigRequestHeaderSize = 8;
+
+  static auto Pad(uint32_t size) -> uint64_t { return (size + 3U) & ~3U; }
+
+  [[nodiscard]] auto Read16(std::size_t offset) const -> uint32_t {
+    return big_endian_ ? ReadBig16(&header_[offset])
+                       : ReadLittle16(&header_[offset]);
+  }
+
+  [[nodiscard]] auto HeaderSize() const -> std::size_t {
+    if (!setup_done_) {
+      return kSetupHeaderSize;
+    }
+    if (header_size_ >= kRequestHeaderSize && Read16(2) == 0) {
+      return kBigRequestHeaderSize;
+    }
+    return kRequestHeaderSize;
+  }
+
+  bool setup_done_ = false;
+  bool big_endian_ = false;
+  std::array<uint8_t, kSetupHeaderSize> header_{};
+  std::size_t header_size_ = 0;
+  uint64_t skip_ = 0;
+
+  DELETE_SPECIAL_MEMBERS(RequestParser);
+};
+
+// Writes all of |data| to |fd|.  Returns false if the peer is gone.
+auto SendAll(int fd, const uint8_t* data, std::size_t size) -> bool {
+  while (size > 0) {
+    auto sent = send(fd, data, size, MSG_NOSIGNAL);
+    if (sent == -1 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    size -= static_cast<std::size_t>(sent);
+  }
+  return true;
+}
+
+}  // namespace
+
+XProxy::XProxy(const std::string& server_display)
+    : server_path_(SocketPath(static_cast<uint32_t>(
+          std::stoul(server_display.substr(server_display.find(':') + 1))))),
+      stop_fd_(MakeEventFd()),
+      listen_fd_(ListenOnFreeDisplay(&display_number_)),
+      path_(SocketPath(display_number_)),
+      display_(DisplayName(display_number_)) {
+  thread_ = std::thread(&XProxy::Run, this);
+}
+
+XProxy::~XProxy() {
+  const uint64_t one = 1;
+  if (write(stop_fd_.get(), &one, sizeof(one)) == -1) {
+    perror("write");
+  }
+  thread_.join();
+  unlink(path_.c_str());
+}
+
+auto XProxy::counts() const -> Counts {
+  return {requests_.load(), bytes_sent_.load(), bytes_received_.load()};
+}
+
+void XProxy::Run() noexcept {
+  try {
+    std::array<struct pollfd, 2> poll_fds{{
+        {listen_fd_.get(), POLLIN, 0},
+        {stop_fd_.get(), POLLIN, 0},
+    }};
+    if (REDO_ON_EINTR(poll(poll_fds.data(), poll_fds.size(), -1)) == -1) {
+      throw PError("poll");
+    }
+    if (poll_fds[1].revents != 0) {
+      return;
+    }
+    const int accepted = REDO_ON_EINTR(
+        accept4(listen_fd_.get(), nullptr, nullptr, SOCK_CLOEXEC));
+    if (accepted == -1) {
+      throw PError("accept4");
+    }
+    ScopedFd client_fd(accepted);
+    ScopedFd server_fd(MakeSocket());
+    const auto address = MakeAddress(server_path_);
+    if (connect(server_fd.get(), reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) == -1) {
+      throw PError("connect");
+    }
+    Relay(client_fd.get(), server_fd.get());
+  } catch (...) {
+    Lippincott();
+  }
+}
+
+void XProxy::Relay(int client_fd, int server_fd) {
+  RequestParser parser;
+  std::array<uint8_t, 65536> buffer{};
+  std::array<struct pollfd, 3> poll_fds{{
+      {client_fd, POLLIN, 0},
+      {server_fd, POLLIN, 0},
+      {stop_fd_.get(), POLLIN, 0},
+  }};
+  while (true) {
+    if (REDO_ON_EINTR(poll(poll_fds.data(), poll_fds.size(), -1)) == -1) {
+      throw PError("poll");
+    }
+    if (poll_fds[2].revents != 0) {
+      return;
+    }
+    for (std::size_t i = 0; i < 2; i++) {
+      if (poll_fds[i].revents == 0) {
+        continue;
+      }
+      const bool from_client = i == 0;
+      auto size = REDO_ON_EINTR(static_cast<int>(
+          read(poll_fds[i].fd, buffer.data(), buffer.size())));
+      if (size == -1) {
+        throw PError("read");
+      }
+      // Either side hanging up ends the session.
+      if (size == 0) {
+        return;
+      }
+      const auto bytes = static_cast<std::size_t>(size);
+      if (from_client) {
+        requests_ += parser.Feed(buffer.data(), bytes);
+        bytes_sent_ += bytes;
+      } else {
+        bytes_received_ += bytes;
+      }
+      if (!SendAll(from_client ? server_fd : client_fd, buffer.data(),
+                   bytes)) {
+        return;
+      }
+    }
+  }
+}
@@ -0,0 +1,71 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "scoped_fd.h"
+#include "util.h"
+
+// Relays one client's connection to an X server on a thread, and counts
+// the requests and bytes the client sends.  This measures the indicator's
+// X traffic as the server sees it, without instrumenting the indicator.
+class XProxy {
+ public:
+  struct Counts {
+    uint64_t requests = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+  };
+
+  // Listens on a free local display number and relays the first client
+  // to connect to |server_display|, which must be of the form ":N".
+  // Throws PError if the socket cannot be created.
+  explicit XProxy(const std::string& server_display);
+  ~XProxy();
+
+  // The display name clients should connect to.
+  [[nodiscard]] auto display() const -> const std::string& {
+    return display_;
+  }
+
+  // Returns the traffic relayed so far.  Thread safe.
+  [[nodiscard]] auto counts() const -> Counts;
+
+ private:
+  void Run() noexcept;
+  void Relay(int client_fd, int server_fd);
+
+  std::string server_path_;
+  ScopedFd stop_fd_;
+  uint32_t display_number_ = 0;
+  ScopedFd listen_fd_;
+  std::string path_;
+  std::string display_;
+
+  std::atomic<uint64_t> requests_{0};
+  std::atomic<uint64_t> bytes_sent_{0};
+  std::atomic<uint64_t> bytes_received_{0};
+
+  std::thread thread_;
+
+  DELETE_SPECIAL_MEMBERS(XProxy);
+};
@@ -0,0 +1,90 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "xvfb.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "p_error.h"
+#include "scoped_fd.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds kStartTimeout{10000};
+
+}  // namespace
+
+Xvfb::Xvfb(uint16_t width, uint16_t height) {
+  // Xvfb picks a free display and writes its number to -displayfd once
+  // it accepts connections.
+  std::array<int, 2> fds{};
+  if (pipe2(fds.data(), O_CLOEXEC) == -1) {
+    throw PError("pipe2");
+  }
+  ScopedFd read_fd(fds[0]);
+  {
+    ScopedFd write_fd(fds[1]);
+    if (fcntl(write_fd.get(), F_SETFD, 0) == -1) {
+      throw PError("fcntl");
+    }
+    process_ = std::make_unique<ChildProcess>(std::vector<std::string>{
+        "Xvfb", "-displayfd", std::to_string(write_fd.get()), "-screen", "0",
+        std::to_string(width) + "x" + std::to_string(height) + "x24",
+        "-nolisten", "tcp", "-noreset"});
+  }
+
+  std::string number;
+  const auto deadline = std::chrono::steady_clock::now() + kStartTimeout;
+  while (number.empty() || number.back() != '\n') {
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    struct pollfd poll_fd {
+      read_fd.get(), POLLIN, 0
+    };
+    int ready = remaining.count() > 0
+                    ? REDO_ON_EINTR(poll(&poll_fd, 1,
+                                         CheckedCast<int>(remaining.count())))
+                    : 0;
+    if (ready == -1) {
+      throw PError("poll");
+    }
+    if (ready == 0) {
+      throw std::runtime_error("Xvfb did not start");
+    }
+    char c;
+    auto size = REDO_ON_EINTR(CheckedCast<int>(read(read_fd.get(), &c, 1)));
+    if (size == -1) {
+      throw PError("read");
+    }
+    if (size == 0) {
+      throw std::runtime_error("Xvfb exited during startup");
+    }
+    number.push_back(c);
+  }
+  number.pop_back();
+  display_ = ":" + number;
+}
+
+Xvfb::~Xvfb() = default;
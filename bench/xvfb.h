@@ -0,0 +1,47 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "child_process.h"
+#include "util.h"
+
+// An Xvfb server on a free display number, so that benchmarks can drive
+// a real X server without a display.  Xvfb must be in $PATH.
+class Xvfb {
+ public:
+  // Throws PError if Xvfb cannot be started and std::runtime_error if it
+  // does not become ready.
+  Xvfb(uint16_t width, uint16_t height);
+  ~Xvfb();
+
+  // The display name, for $DISPLAY or xcb_connect().
+  [[nodiscard]] auto display() const -> const std::string& {
+    return display_;
+  }
+  [[nodiscard]] auto pid() const -> pid_t { return process_->pid(); }
+
+ private:
+  std::unique_ptr<ChildProcess> process_;
+  std::string display_;
+
+  DELETE_SPECIAL_MEMBERS(Xvfb);
+};
@@ -19,21 +19,31 @@
 
 #include <xcb/xproto.h>
 
+#include <memory>
+
+#include "allocation_counter.h"
 #include "border_window.h"
+#include "command_line.h"
 #include "event_loop.h"
 #include "window_geometry_tracker.h"
 
 ActiveWindowIndicator::ActiveWindowIndicator(Connection* connection,
                                              EventLoop* event_loop,
-                                             CommandLine* command_line)
+                                             CommandLine* command_line,
+                                             const StartupInfo& startup_info)
     : connection_(connection),
       event_loop_(event_loop),
       border_window_(connection_, command_line),
-      active_window_tracker_(connection_, event_loop_),
-      key_listener_(connection_, event_loop_),
+      active_window_tracker_(connection_, event_loop_, startup_info),
+      key_listener_(connection_, event_loop_, startup_info),
       active_window_observer_(this, &active_window_tracker_),
       event_loop_idle_observer_(this, event_loop),
-      key_state_observer_(this, &key_listener_) {}
+      key_state_observer_(this, &key_listener_) {
+  if (command_line->frame_pacing()) {
+    frame_pacer_ = std::make_unique<FramePacer>(
+        connection_, event_loop_, [this]() { UpdateBorder(); });
+  }
+}
 
 ActiveWindowIndicator::~ActiveWindowIndicator() = default;
 
@@ -42,23 +52,7 @@ void ActiveWindowIndicator::ActiveWindowChanged() {
 }
 
 void ActiveWindowIndicator::OnIdle() {
-  // TODO(tomKPZ): take border width into account for position and size.
-  if (needs_set_position_) {
-    border_window_.SetPosition(window_geometry_tracker_->X(),
-                               window_geometry_tracker_->Y());
-  }
-  needs_set_position_ = false;
-
-  if (needs_set_size_) {
-    border_window_.SetSize(window_geometry_tracker_->width(),
-                           window_geometry_tracker_->height());
-  }
-  needs_set_size_ = false;
-
-  if (needs_show_) {
-    border_window_.Show();
-  }
-  needs_show_ = false;
+  UpdateBorder();
 }
 
 void ActiveWindowIndicator::KeyStateChanged() {
@@ -78,7 +72,45 @@ void ActiveWindowIndicator::WindowBorderWidthChanged() {
   needs_set_size_ = true;
 }
 
+void ActiveWindowIndicator::UpdateBorder() {
+  // Keep the pending updates until the geometry of the whole ancestor
+  // chain has arrived.
+  if (window_geometry_tracker_ && !window_geometry_tracker_->Ready()) {
+    return;
+  }
+
+  // While the window moves, send at most one update per frame.  The first
+  // update after a pause is sent at once.  Later ones are held while a
+  // frame is pending and sent when it arrives, so the border trails the
+  // window by at most one frame.  Showing the border is never delayed.
+  if (frame_pacer_ && (needs_set_position_ || needs_set_size_)) {
+    if (frame_pacer_->frame_pending() && !needs_show_) {
+      return;
+    }
+    frame_pacer_->RequestFrame();
+  }
+
+  // TODO(tomKPZ): take border width into account for position and size.
+  if (needs_set_position_) {
+    border_window_.SetPosition(window_geometry_tracker_->X(),
+                               window_geometry_tracker_->Y());
+  }
+  needs_set_position_ = false;
+
+  if (needs_set_size_) {
+    border_window_.SetSize(window_geometry_tracker_->width(),
+                           window_geometry_tracker_->height());
+  }
+  needs_set_size_ = false;
+
+  if (needs_show_) {
+    border_window_.Show();
+  }
+  needs_show_ = false;
+}
+
 void ActiveWindowIndicator::OnStateChanged() {
+  ScopedAllocationPhase activation_phase(AllocationPhase::kActivation);
   const bool show = key_listener_.any_key_pressed() &&
                     active_window_tracker_.active_window() != XCB_WINDOW_NONE;
   needs_set_position_ = show;
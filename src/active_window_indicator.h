@@ -23,6 +23,7 @@
 #include "active_window_tracker.h"
 #include "border_window.h"
 #include "event_loop_idle_observer.h"
+#include "frame_pacer.h"
 #include "key_listener.h"
 #include "key_state_observer.h"
 #include "scoped_observer.h"
@@ -33,6 +34,7 @@
 class CommandLine;
 class Connection;
 class EventLoop;
+class StartupInfo;
 
 class ActiveWindowIndicator : public ActiveWindowObserver,
                               public EventLoopIdleObserver,
@@ -41,9 +43,18 @@ class ActiveWindowIndicator : public ActiveWindowObserver,
  public:
   ActiveWindowIndicator(Connection* connection,
                         EventLoop* event_loop,
-                        CommandLine* command_line);
+                        CommandLine* command_line,
+                        const StartupInfo& startup_info);
   ~ActiveWindowIndicator() override;
 
+  [[nodiscard]] auto active_window_tracker() const
+      -> const ActiveWindowTracker& {
+    return active_window_tracker_;
+  }
+  [[nodiscard]] auto border_window() const -> const BorderWindow& {
+    return border_window_;
+  }
+
  protected:
   // ActiveWindowObserver:
   void ActiveWindowChanged() override;
@@ -62,6 +73,10 @@ class ActiveWindowIndicator : public ActiveWindowObserver,
  private:
   void OnStateChanged();
 
+  // Sends the pending border updates, unless they must wait for the
+  // geometry to arrive or for the next frame.
+  void UpdateBorder();
+
   void SetBorderWindowBounds();
 
   Connection* connection_;
@@ -77,6 +92,9 @@ class ActiveWindowIndicator : public ActiveWindowObserver,
   bool needs_set_size_ = false;
   bool needs_show_ = false;
 
+  // Null unless frame pacing was requested.
+  std::unique_ptr<FramePacer> frame_pacer_;
+
   std::unique_ptr<WindowGeometryTracker> window_geometry_tracker_{};
   std::unique_ptr<ScopedObserver<WindowGeometryObserver>>
       window_geometry_observer_{};
@@ -19,82 +19,27 @@
 
 #include <xcb/xproto.h>
 
-#include <algorithm>
-#include <climits>
 #include <forward_list>
-#include <limits>
-#include <memory>
-#include <string>
-#include <vector>
 
 #include "active_window_observer.h"
 #include "connection.h"
-#include "event.h"
 #include "event_loop.h"
-#include "util.h"
-#include "x_error.h"
-
-namespace {
-
-auto GetAtom(Connection* connection, const std::string& str) -> xcb_atom_t {
-  return XCB_SYNC(xcb_intern_atom, connection, false,
-                  CheckedCast<uint16_t>(str.length()), str.c_str())
-      ->atom;
-}
-
-auto GetAtomArray(Connection* connection,
-                  const xcb_window_t& window,
-                  xcb_atom_t atom) -> std::vector<xcb_atom_t> {
-  auto reply = XCB_SYNC(xcb_get_property, connection, false, window, atom,
-                        XCB_ATOM_ATOM, 0, std::numeric_limits<uint32_t>::max());
-
-  if (reply->format != CHAR_BIT * sizeof(xcb_atom_t) ||
-      reply->type != XCB_ATOM_ATOM || reply->bytes_after > 0) {
-    throw XError("Bad property reply");
-  }
-
-  const xcb_atom_t* value =
-      reinterpret_cast<xcb_atom_t*>(xcb_get_property_value(reply.get()));
-  return std::vector<xcb_atom_t>(value, value + reply->value_len);
-}
-
-auto GetWindow(Connection* connection,
-               const xcb_window_t& window,
-               xcb_atom_t atom) -> xcb_window_t {
-  auto reply = XCB_SYNC(xcb_get_property, connection, false, window, atom,
-                        XCB_ATOM_WINDOW, 0, sizeof(xcb_window_t));
-
-  if (reply->format != CHAR_BIT * sizeof(xcb_window_t) ||
-      reply->type != XCB_ATOM_WINDOW || reply->bytes_after > 0 ||
-      xcb_get_property_value_length(reply.get()) != sizeof(xcb_window_t)) {
-    throw XError("Bad property reply");
-  }
-
-  return reinterpret_cast<xcb_window_t*>(
-      xcb_get_property_value(reply.get()))[0];
-}
-
-}  // namespace
+#include "property.h"
+#include "startup_info.h"
+#include "tracer.h"
 
 ActiveWindowTracker::ActiveWindowTracker(Connection* connection,
-                                         EventLoop* event_loop)
+                                         EventLoop* event_loop,
+                                         const StartupInfo& startup_info)
     : connection_(connection),
-      event_dispatcher_(this, event_loop),
-      net_active_window_(XCB_ATOM_NONE),
-      active_window_(XCB_WINDOW_NONE) {
-  xcb_atom_t net_supported = GetAtom(connection_, "_NET_SUPPORTED");
-  net_active_window_ = GetAtom(connection_, "_NET_ACTIVE_WINDOW");
-
-  auto atoms =
-      GetAtomArray(connection_, connection_->root_window(), net_supported);
-  if (std::find(atoms.begin(), atoms.end(), net_active_window_) ==
-      atoms.end()) {
-    throw XError("WM does not support active window");
-  }
-
+      event_handlers_(
+          event_loop,
+          {EventHandler::ForWindow<&ActiveWindowTracker::OnPropertyNotify>(
+              this, connection->root_window(), EventPriority::kState)}),
+      net_active_window_(startup_info.net_active_window()),
+      active_window_(startup_info.active_window()) {
   connection_->SelectEvents(connection_->root_window(),
                             XCB_EVENT_MASK_PROPERTY_CHANGE);
-  SetActiveWindow();
 }
 
 ActiveWindowTracker::~ActiveWindowTracker() {
@@ -102,31 +47,29 @@ ActiveWindowTracker::~ActiveWindowTracker() {
                               XCB_EVENT_MASK_PROPERTY_CHANGE);
 }
 
-auto ActiveWindowTracker::DispatchEvent(const Event& event) -> bool {
-  if (event.ResponseType() != XCB_PROPERTY_NOTIFY) {
-    return false;
-  }
-
-  const auto* property_notify_event =
-      reinterpret_cast<const xcb_property_notify_event_t*>(event.event());
-
-  if (property_notify_event->window != connection_->root_window()) {
-    return false;
-  }
-
-  if (property_notify_event->atom != net_active_window_) {
-    return true;
+void ActiveWindowTracker::OnPropertyNotify(
+    const xcb_property_notify_event_t& property_notify_event) {
+  if (property_notify_event.atom == net_active_window_) {
+    FetchActiveWindow();
   }
+}
 
-  SetActiveWindow();
-  return true;
+void ActiveWindowTracker::FetchActiveWindow() {
+  // Replaces any outstanding request, since only the latest value matters.
+  active_window_request_ = XCB_ASYNC_REPLY(
+      xcb_get_property, connection_,
+      RequestWindow(connection_, connection_->root_window(),
+                    net_active_window_),
+      [this](XcbReply<xcb_get_property_reply_t> reply) {
+        SetActiveWindow(WindowFromReply(*reply));
+      });
 }
 
-void ActiveWindowTracker::SetActiveWindow() {
-  xcb_window_t active_window =
-      GetWindow(connection_, connection_->root_window(), net_active_window_);
+void ActiveWindowTracker::SetActiveWindow(xcb_window_t active_window) {
   if (active_window_ != active_window) {
     active_window_ = active_window;
+    changes_++;
+    TRACE_SPAN("observer", "ActiveWindowChanged");
     for (auto* observer : observers()) {
       observer->ActiveWindowChanged();
     }
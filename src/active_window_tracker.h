@@ -17,11 +17,13 @@
 
 #pragma once
 
+#include <xcb/xproto.h>
+
 #include <cstdint>
 
-#include "event_dispatcher.h"
+#include "async_request.h"
 #include "observable.h"
-#include "scoped_observer.h"
+#include "scoped_event_handlers.h"
 #include "util.h"
 
 using xcb_atom_t = std::uint32_t;
@@ -29,31 +31,36 @@ using xcb_window_t = std::uint32_t;
 
 class ActiveWindowObserver;
 class Connection;
-class Event;
 class EventLoop;
+class StartupInfo;
 
-class ActiveWindowTracker : public EventDispatcher,
-                            public Observable<ActiveWindowObserver> {
+class ActiveWindowTracker : public Observable<ActiveWindowObserver> {
  public:
-  ActiveWindowTracker(Connection* connection, EventLoop* event_loop);
+  ActiveWindowTracker(Connection* connection,
+                      EventLoop* event_loop,
+                      const StartupInfo& startup_info);
   ~ActiveWindowTracker() override;
 
   [[nodiscard]] auto active_window() const -> xcb_window_t {
     return active_window_;
   }
 
- protected:
-  // EventDispatcher:
-  auto DispatchEvent(const Event& event) -> bool override;
+  // Number of times the active window changed.
+  [[nodiscard]] auto changes() const -> uint64_t { return changes_; }
 
  private:
-  void SetActiveWindow();
+  void OnPropertyNotify(
+      const xcb_property_notify_event_t& property_notify_event);
+  void FetchActiveWindow();
+  void SetActiveWindow(xcb_window_t active_window);
 
   Connection* connection_;
-  ScopedObserver<EventDispatcher> event_dispatcher_;
+  ScopedEventHandlers event_handlers_;
+  AsyncRequest active_window_request_;
 
   xcb_atom_t net_active_window_;
   xcb_window_t active_window_;
+  uint64_t changes_ = 0;
 
   DELETE_SPECIAL_MEMBERS(ActiveWindowTracker);
 };
@@ -0,0 +1,66 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "allocation_counter.h"
+
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+
+auto AllocationPhaseName(AllocationPhase phase) -> const char* {
+  switch (phase) {
+    case AllocationPhase::kNone:
+      return "none";
+    case AllocationPhase::kStartup:
+      return "startup";
+    case AllocationPhase::kActivation:
+      return "activation";
+    case AllocationPhase::kEvent:
+      return "event";
+    case AllocationPhase::kIdle:
+      return "idle";
+  }
+  return "unknown";
+}
+
+// static
+auto AllocationCounter::Counts(AllocationPhase phase) -> AllocationCounts {
+  const auto index = static_cast<std::size_t>(phase);
+  return {allocations_[index].load(std::memory_order_relaxed),
+          bytes_[index].load(std::memory_order_relaxed)};
+}
+
+// static
+auto AllocationCounter::ThreadAllocations() -> uint64_t {
+  return std::accumulate(thread_allocations_.begin(),
+                         thread_allocations_.end(), uint64_t{0});
+}
+
+// static
+void AllocationCounter::Print(std::ostream& stream) {
+  stream << std::left << std::setw(12) << "phase" << std::right
+         << std::setw(14) << "allocations" << std::setw(14) << "bytes"
+         << '\n';
+  for (std::size_t i = 0; i < kNumAllocationPhases; i++) {
+    const auto phase = static_cast<AllocationPhase>(i);
+    const auto counts = Counts(phase);
+    stream << std::left << std::setw(12) << AllocationPhaseName(phase)
+           << std::right << std::setw(14) << counts.allocations
+           << std::setw(14) << counts.bytes << '\n';
+  }
+  stream << std::flush;
+}
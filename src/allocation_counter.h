@@ -0,0 +1,114 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "util.h"
+
+// The part of the indicator's life an allocation is charged to.
+enum class AllocationPhase : uint8_t {
+  // Outside the phases below, such as on threads other than the loop's.
+  kNone,
+  // Before the event loop starts.
+  kStartup,
+  // Showing the border or following a new active window, including
+  // building the geometry trackers of its ancestors.
+  kActivation,
+  // Handling an event or a reply.
+  kEvent,
+  // Idle passes, timers and other file descriptors.
+  kIdle,
+};
+
+constexpr std::size_t kNumAllocationPhases = 5;
+
+auto AllocationPhaseName(AllocationPhase phase) -> const char*;
+
+struct AllocationCounts {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+};
+
+// Counts calls to the global operator new by phase.  Nothing is counted
+// unless allocation_hooks.cpp, which replaces the global allocator, is
+// linked in: the benchmarks always link it, and the indicator does when
+// configured with -DALLOCATION_COUNTING=ON.  XCB allocates with malloc(),
+// which is not counted.
+class AllocationCounter {
+ public:
+  // Returns true iff the allocator is hooked.
+  static auto enabled() -> bool { return enabled_; }
+
+  // Returns the allocations of all threads in |phase|.
+  static auto Counts(AllocationPhase phase) -> AllocationCounts;
+
+  // Returns how many allocations the calling thread made in |phase|.
+  static auto ThreadAllocations(AllocationPhase phase) -> uint64_t {
+    return thread_allocations_[static_cast<std::size_t>(phase)];
+  }
+
+  // Returns how many allocations the calling thread made in any phase.
+  static auto ThreadAllocations() -> uint64_t;
+
+  // The phase of the calling thread.
+  static auto phase() -> AllocationPhase { return phase_; }
+  static void set_phase(AllocationPhase phase) { phase_ = phase; }
+
+  // Prints the counts of each phase.
+  static void Print(std::ostream& stream);
+
+  // Called by the allocator hooks.
+  static void Enable() { enabled_ = true; }
+  static void RecordAllocation(std::size_t size) {
+    const auto phase = static_cast<std::size_t>(phase_);
+    thread_allocations_[phase]++;
+    allocations_[phase].fetch_add(1, std::memory_order_relaxed);
+    bytes_[phase].fetch_add(size, std::memory_order_relaxed);
+  }
+
+ private:
+  inline static bool enabled_ = false;
+  inline static thread_local AllocationPhase phase_ = AllocationPhase::kNone;
+  inline static thread_local std::array<uint64_t, kNumAllocationPhases>
+      thread_allocations_{};
+  inline static std::array<std::atomic<uint64_t>, kNumAllocationPhases>
+      allocations_{};
+  inline static std::array<std::atomic<uint64_t>, kNumAllocationPhases>
+      bytes_{};
+};
+
+// Charges the calling thread's allocations to |phase| until destruction,
+// then restores the previous phase.
+class ScopedAllocationPhase {
+ public:
+  explicit ScopedAllocationPhase(AllocationPhase phase)
+      : previous_(AllocationCounter::phase()) {
+    AllocationCounter::set_phase(phase);
+  }
+  ~ScopedAllocationPhase() { AllocationCounter::set_phase(previous_); }
+
+ private:
+  AllocationPhase previous_;
+
+  DELETE_SPECIAL_MEMBERS(ScopedAllocationPhase);
+};
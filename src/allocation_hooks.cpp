@@ -0,0 +1,74 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+// Replaces the global allocator to feed AllocationCounter.  Only linked
+// into builds that count allocations.  The array and nothrow forms call
+// these by default, so they are counted too.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+namespace {
+
+const bool kEnabled = [] {
+  AllocationCounter::Enable();
+  return true;
+}();
+
+}  // namespace
+
+auto operator new(std::size_t size) -> void* {
+  AllocationCounter::RecordAllocation(size);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {  // NOLINT
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);  // NOLINT
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment) -> void* {
+  AllocationCounter::RecordAllocation(size);
+  const auto align = static_cast<std::size_t>(alignment);
+  // aligned_alloc() requires a size that is a multiple of the alignment.
+  const std::size_t rounded =
+      (std::max(size, align) + align - 1) / align * align;
+  if (void* ptr = std::aligned_alloc(align, rounded)) {  // NOLINT
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+
+void operator delete(void* ptr,
+                     std::size_t /*size*/,
+                     std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
@@ -0,0 +1,102 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "async_request.h"
+
+#include "timeout_error.h"
+
+ReplyHandler::ReplyHandler(unsigned int sequence,
+                           const RequestSite& site,
+                           Clock::duration timeout)
+    : sequence_(sequence),
+      site_(site),
+      start_(Clock::now()),
+      deadline_(start_ + timeout) {}
+
+ReplyHandler::~ReplyHandler() {
+  if (request_ != nullptr) {
+    request_->handler_ = nullptr;
+  }
+}
+
+void ReplyHandler::Complete(void* reply, xcb_generic_error_t* error) {
+  std::unique_ptr<void, FreeDeleter> owned_reply(reply);
+  std::unique_ptr<xcb_generic_error_t, FreeDeleter> owned_error(error);
+  if (request_ == nullptr) {
+    return;
+  }
+  request_->handler_ = nullptr;
+  request_ = nullptr;
+
+  if (owned_error) {
+    throw XError(*owned_error);
+  }
+  if (!owned_reply) {
+    throw XError("Connection closed before reply was received");
+  }
+  OnReply(owned_reply.release());
+}
+
+void ReplyHandler::Expire() {
+  if (request_ == nullptr) {
+    return;
+  }
+  request_->handler_ = nullptr;
+  request_ = nullptr;
+
+  throw TimeoutError(site_,
+                     std::chrono::duration_cast<std::chrono::milliseconds>(
+                         Clock::now() - start_));
+}
+
+AsyncRequest::AsyncRequest(ReplyHandler* handler)
+    : handler_(handler), sequence_(handler->sequence()) {
+  DCHECK(handler_->request_ == nullptr);
+  handler_->request_ = this;
+}
+
+AsyncRequest::~AsyncRequest() {
+  Cancel();
+}
+
+AsyncRequest::AsyncRequest(AsyncRequest&& other) noexcept
+    : handler_(other.handler_), sequence_(other.sequence_) {
+  other.handler_ = nullptr;
+  if (handler_ != nullptr) {
+    handler_->request_ = this;
+  }
+}
+
+auto AsyncRequest::operator=(AsyncRequest&& other) noexcept -> AsyncRequest& {
+  if (this != &other) {
+    Cancel();
+    handler_ = other.handler_;
+    sequence_ = other.sequence_;
+    other.handler_ = nullptr;
+    if (handler_ != nullptr) {
+      handler_->request_ = this;
+    }
+  }
+  return *this;
+}
+
+void AsyncRequest::Cancel() {
+  if (handler_ != nullptr) {
+    handler_->request_ = nullptr;
+    handler_ = nullptr;
+  }
+}
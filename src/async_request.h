@@ -0,0 +1,128 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "request_site.h"
+#include "util.h"
+#include "x_error.h"
+
+class AsyncRequest;
+
+// Receives the reply to a request sent with XCB_ASYNC.  Owned by the
+// Connection until the reply arrives.
+class ReplyHandler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  ReplyHandler(unsigned int sequence,
+               const RequestSite& site,
+               Clock::duration timeout);
+  virtual ~ReplyHandler();
+
+  [[nodiscard]] auto sequence() const -> unsigned int { return sequence_; }
+  [[nodiscard]] auto site() const -> const RequestSite& { return site_; }
+  [[nodiscard]] auto start() const -> Clock::time_point { return start_; }
+  [[nodiscard]] auto deadline() const -> Clock::time_point {
+    return deadline_;
+  }
+
+  // Takes ownership of |reply| and |error|.  Exactly one of them is
+  // non-null unless the connection has an error.  Does nothing if the
+  // request was cancelled.
+  void Complete(void* reply, xcb_generic_error_t* error);
+
+  // Called instead of Complete() if the deadline passes first.  Throws
+  // TimeoutError unless the request was cancelled.
+  void Expire();
+
+ protected:
+  virtual void OnReply(void* reply) = 0;
+
+ private:
+  friend class AsyncRequest;
+
+  unsigned int sequence_;
+  RequestSite site_;
+  Clock::time_point start_;
+  Clock::time_point deadline_;
+
+  // The handle that cancels this request when destroyed, or null if the
+  // request was cancelled.
+  AsyncRequest* request_ = nullptr;
+
+  DELETE_SPECIAL_MEMBERS(ReplyHandler);
+};
+
+template <typename Reply>
+class TypedReplyHandler : public ReplyHandler {
+ public:
+  using Callback = std::function<void(std::unique_ptr<Reply, FreeDeleter>)>;
+
+  TypedReplyHandler(unsigned int sequence,
+                    const RequestSite& site,
+                    Clock::duration timeout,
+                    Callback callback)
+      : ReplyHandler(sequence, site, timeout), callback_(std::move(callback)) {}
+  ~TypedReplyHandler() override = default;
+
+ protected:
+  void OnReply(void* reply) override {
+    callback_(std::unique_ptr<Reply, FreeDeleter>(static_cast<Reply*>(reply)));
+  }
+
+ private:
+  Callback callback_;
+
+  DELETE_SPECIAL_MEMBERS(TypedReplyHandler);
+};
+
+// Handle to an outstanding request sent with XCB_ASYNC.  The reply
+// callback will not be run after the handle is destroyed or reassigned.
+class AsyncRequest {
+ public:
+  AsyncRequest() = default;
+  explicit AsyncRequest(ReplyHandler* handler);
+  ~AsyncRequest();
+
+  AsyncRequest(AsyncRequest&& other) noexcept;
+  auto operator=(AsyncRequest&& other) noexcept -> AsyncRequest&;
+  AsyncRequest(const AsyncRequest&) = delete;
+  auto operator=(const AsyncRequest&) -> AsyncRequest& = delete;
+
+  // Returns true iff the reply has not been handled yet.
+  [[nodiscard]] auto pending() const -> bool { return handler_ != nullptr; }
+
+  // The sequence number of the request, or 0 for a default-constructed
+  // handle.  Stays valid after the reply was handled.
+  [[nodiscard]] auto sequence() const -> unsigned int { return sequence_; }
+
+  void Cancel();
+
+ private:
+  friend class ReplyHandler;
+
+  ReplyHandler* handler_ = nullptr;
+  unsigned int sequence_ = 0;
+};
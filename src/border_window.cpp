@@ -22,24 +22,26 @@
 #include <xcb/xfixes.h>
 #include <xcb/xproto.h>
 
+#include <algorithm>
 #include <array>
-#include <vector>
+#include <cstddef>
+#include <span>
 
 #include "command_line.h"
 #include "connection.h"
+#include "probes.h"
 #include "util.h"
-#include "x_error.h"
 
 namespace {
 
 class XcbRegion {
  public:
-  XcbRegion(Connection* connection, const std::vector<xcb_rectangle_t>& rects)
+  XcbRegion(Connection* connection, std::span<const xcb_rectangle_t> rects)
       : connection_(connection), id_(connection_->GenerateId()) {
-    xcb_xfixes_create_region(connection_->connection(), id_,
-                             CheckedCast<uint32_t>(rects.size()), rects.data());
+    XCB_VOID(xcb_xfixes_create_region, connection_, id_,
+             CheckedCast<uint32_t>(rects.size()), rects.data());
   }
-  ~XcbRegion() { xcb_xfixes_destroy_region(connection_->connection(), id_); }
+  ~XcbRegion() { XCB_VOID(xcb_xfixes_destroy_region, connection_, id_); }
   [[nodiscard]] auto Id() const -> uint32_t { return id_; }
 
  private:
@@ -49,52 +51,96 @@ class XcbRegion {
   DELETE_SPECIAL_MEMBERS(XcbRegion);
 };
 
+// Returns the bounds of the top, bottom, left and right edges of a
+// border at |x|, |y| of size |width| by |height|.  Windows cannot be
+// empty, so each edge is at least one pixel in each dimension.
+auto EdgeBounds(int16_t x,
+                int16_t y,
+                uint16_t width,
+                uint16_t height,
+                uint16_t border_width) -> std::array<xcb_rectangle_t, 4> {
+  const auto w = std::max<uint16_t>(width, 1);
+  const auto h = std::max<uint16_t>(height, 1);
+  const auto bw = std::max<uint16_t>(border_width, 1);
+  return {{
+      {x, y, w, bw},
+      {x, CheckedCast<int16_t>(y + height - border_width), w, bw},
+      {x, y, bw, h},
+      {CheckedCast<int16_t>(x + width - border_width), y, bw, h},
+  }};
+}
+
 }  // namespace
 
 BorderWindow::BorderWindow(Connection* connection, CommandLine* command_line)
     : connection_(connection), command_line_(command_line) {
-  window_ = connection_->GenerateId();
+  const bool edges =
+      command_line_->border_strategy() == BorderStrategy::kEdges;
   std::array<uint32_t, 2> attributes{command_line_->border_color(), 1U};
-  xcb_create_window(connection_->connection(), XCB_COPY_FROM_PARENT, window_,
-                    connection_->root_window(), 0, 0, 1, 1, 0,
-                    XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
-                    XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT,
-                    attributes.data());
-
-  XCB_SYNC(xcb_xfixes_query_version, connection_, XCB_XFIXES_MAJOR_VERSION,
-           XCB_XFIXES_MINOR_VERSION);
-  auto* fixes_extension =
-      xcb_get_extension_data(connection_->connection(), &xcb_xfixes_id);
-  if (fixes_extension->present == 0U) {
-    throw XError("XFIXES not available");
+  windows_.resize(edges ? 4 : 1);
+  for (auto& window : windows_) {
+    window = connection_->GenerateId();
+    XCB_VOID(xcb_create_window, connection_, XCB_COPY_FROM_PARENT, window,
+             connection_->root_window(), 0, 0, 1, 1, 0,
+             XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+             XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, attributes.data());
+  }
+  if (edges) {
+    // The edges never change shape, so their input shape is cleared once
+    // rather than on every resize.
+    const XcbRegion empty(connection_, {});
+    for (xcb_window_t window : windows_) {
+      XCB_VOID(xcb_xfixes_set_window_shape_region, connection_, window,
+               XCB_SHAPE_SK_INPUT, 0, 0, empty.Id());
+    }
   }
 }
 
 BorderWindow::~BorderWindow() {
-  xcb_destroy_window(connection_->connection(), window_);
+  for (xcb_window_t window : windows_) {
+    XCB_VOID(xcb_destroy_window, connection_, window);
+  }
 }
 
 void BorderWindow::SetPosition(int16_t x, int16_t y) {
+  PROBE3(border__set__position, windows_[0], x, y);
+  updates_++;
+  x_ = x;
+  y_ = y;
+  if (windows_.size() > 1) {
+    ConfigureEdges(XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y);
+    return;
+  }
   xcb_configure_window_value_list_t configure{};
   configure.x = x;
   configure.y = y;
-  xcb_configure_window_aux(connection_->connection(), window_,
-                           XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y,
-                           &configure);
+  XCB_VOID(xcb_configure_window_aux, connection_, windows_[0],
+           XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, &configure);
 }
 
 void BorderWindow::SetSize(uint16_t width, uint16_t height) {
+  PROBE3(border__set__size, windows_[0], width, height);
+  updates_++;
+  width_ = width;
+  height_ = height;
+  if (windows_.size() > 1) {
+    // The bottom and right edges move with the size.
+    ConfigureEdges(XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
+                   XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT);
+    return;
+  }
+  const xcb_window_t window = windows_[0];
   // TODO(tomKPZ): Use an outer border instead of an inner border if the window
   // is tiny.
   xcb_configure_window_value_list_t configure{};
   configure.width = CheckedCast<uint16_t>(width);
   configure.height = CheckedCast<uint16_t>(height);
-  xcb_configure_window_aux(connection_->connection(), window_,
-                           XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                           &configure);
+  XCB_VOID(xcb_configure_window_aux, connection_, window,
+           XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, &configure);
 
   const uint16_t border_width = command_line_->border_width();
-  const std::vector<xcb_rectangle_t> rects{
+  // An array rather than a vector, so that resizing does not allocate.
+  const std::array<xcb_rectangle_t, 4> rects{{
       // Top edge.
       {0, 0, width, border_width},
       // Bottom edge.
@@ -103,28 +149,51 @@ void BorderWindow::SetSize(uint16_t width, uint16_t height) {
       {0, 0, border_width, height},
       // Right edge.
       {CheckedCast<int16_t>(width - border_width), 0, border_width, height},
-  };
-
-  xcb_xfixes_set_window_shape_region(connection_->connection(), window_,
-                                     XCB_SHAPE_SK_BOUNDING, 0, 0,
-                                     XcbRegion(connection_, rects).Id());
-  xcb_xfixes_set_window_shape_region(connection_->connection(), window_,
-                                     XCB_SHAPE_SK_INPUT, 0, 0,
-                                     XcbRegion(connection_, {}).Id());
+  }};
+
+  XCB_VOID(xcb_xfixes_set_window_shape_region, connection_, window,
+           XCB_SHAPE_SK_BOUNDING, 0, 0, XcbRegion(connection_, rects).Id());
+  XCB_VOID(xcb_xfixes_set_window_shape_region, connection_, window,
+           XCB_SHAPE_SK_INPUT, 0, 0, XcbRegion(connection_, {}).Id());
 }
 
 void BorderWindow::Show() {
-  xcb_map_window(connection_->connection(), window_);
+  PROBE1(border__show, windows_[0]);
+  updates_++;
+  for (xcb_window_t window : windows_) {
+    XCB_VOID(xcb_map_window, connection_, window);
+  }
   Raise();
 }
 
 void BorderWindow::Hide() {
-  xcb_unmap_window(connection_->connection(), window_);
+  PROBE1(border__hide, windows_[0]);
+  updates_++;
+  for (xcb_window_t window : windows_) {
+    XCB_VOID(xcb_unmap_window, connection_, window);
+  }
 }
 
 void BorderWindow::Raise() {
+  PROBE1(border__raise, windows_[0]);
   xcb_configure_window_value_list_t configure{};
   configure.stack_mode = XCB_STACK_MODE_ABOVE;
-  xcb_configure_window_aux(connection_->connection(), window_,
-                           XCB_CONFIG_WINDOW_STACK_MODE, &configure);
+  for (xcb_window_t window : windows_) {
+    XCB_VOID(xcb_configure_window_aux, connection_, window,
+             XCB_CONFIG_WINDOW_STACK_MODE, &configure);
+  }
+}
+
+void BorderWindow::ConfigureEdges(uint16_t value_mask) {
+  const auto bounds =
+      EdgeBounds(x_, y_, width_, height_, command_line_->border_width());
+  for (std::size_t i = 0; i < windows_.size(); i++) {
+    xcb_configure_window_value_list_t configure{};
+    configure.x = bounds[i].x;
+    configure.y = bounds[i].y;
+    configure.width = bounds[i].width;
+    configure.height = bounds[i].height;
+    XCB_VOID(xcb_configure_window_aux, connection_, windows_[i], value_mask,
+             &configure);
+  }
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "util.h"
 
@@ -26,6 +27,8 @@ using xcb_window_t = uint32_t;
 class CommandLine;
 class Connection;
 
+// Draws the border in the way CommandLine::border_strategy() selects.
+// Either way the border lets input through to the windows below.
 class BorderWindow {
  public:
   explicit BorderWindow(Connection* connection, CommandLine* command_line);
@@ -37,14 +40,31 @@ class BorderWindow {
   void Show();
   void Hide();
 
+  // Number of times the border was moved, resized, shown or hidden.
+  [[nodiscard]] auto updates() const -> uint64_t { return updates_; }
+
  private:
   void Raise();
 
+  // Sets the fields in |value_mask| of each edge window to the bounds
+  // last requested.
+  void ConfigureEdges(uint16_t value_mask);
+
   Connection* connection_;
 
   CommandLine* command_line_;
 
-  xcb_window_t window_;
+  // One window for BorderStrategy::kShape, or the top, bottom, left and
+  // right edges for BorderStrategy::kEdges.
+  std::vector<xcb_window_t> windows_;
+
+  // The bounds last requested, which position the edge windows.
+  int16_t x_ = 0;
+  int16_t y_ = 0;
+  uint16_t width_ = 1;
+  uint16_t height_ = 1;
+
+  uint64_t updates_ = 0;
 
   DELETE_SPECIAL_MEMBERS(BorderWindow);
 };
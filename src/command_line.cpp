@@ -31,6 +31,10 @@ namespace {
 
 constexpr const uint32_t kDefaultBorderColor = 0xffff0000;
 constexpr const uint16_t kDefaultBorderWidth = 5;
+constexpr const std::chrono::milliseconds kDefaultRequestTimeout{10000};
+constexpr const std::chrono::milliseconds kDefaultStallThreshold{250};
+constexpr const uint32_t kDefaultIdleEventLimit = 256;
+constexpr const std::chrono::microseconds kDefaultIdleTimeLimit{4000};
 
 template <typename T, typename Format>
 auto ParseInt(const std::string& str, Format format) -> T {
@@ -43,10 +47,26 @@ auto ParseInt(const std::string& str, Format format) -> T {
   return value;
 }
 
+auto ParseBorderStrategy(const std::string& str) -> BorderStrategy {
+  if (str == "shape") {
+    return BorderStrategy::kShape;
+  }
+  if (str == "edges") {
+    return BorderStrategy::kEdges;
+  }
+  std::cerr << "Unknown border strategy: " << str << std::endl;
+  throw UsageError{};
+}
+
 }  // namespace
 
 CommandLine::CommandLine(int argc, char** argv)
-    : border_color_{kDefaultBorderColor}, border_width_{kDefaultBorderWidth} {
+    : border_color_{kDefaultBorderColor},
+      border_width_{kDefaultBorderWidth},
+      request_timeout_{kDefaultRequestTimeout},
+      stall_threshold_{kDefaultStallThreshold},
+      idle_event_limit_{kDefaultIdleEventLimit},
+      idle_time_limit_{kDefaultIdleTimeLimit} {
   Init(argc, argv);
   if (optind < argc) {
     std::cerr << "Unconsumed arguments: ";
@@ -60,14 +80,27 @@ CommandLine::CommandLine(int argc, char** argv)
 
 void CommandLine::Init(int argc, char** argv) {
   while (true) {
-    constexpr std::array<struct option, 4> kLongOptions{
+    constexpr std::array<struct option, 16> kLongOptions{
         {{"help", no_argument, nullptr, 'h'},
          {"border-color", required_argument, nullptr, 'c'},
          {"border-width", required_argument, nullptr, 'w'},
+         {"border-strategy", required_argument, nullptr, 'b'},
+         {"startup-profile", no_argument, nullptr, 'p'},
+         {"request-stats", no_argument, nullptr, 'r'},
+         {"request-timeout", required_argument, nullptr, 't'},
+         {"stall-threshold", required_argument, nullptr, 's'},
+         {"frame-pacing", no_argument, nullptr, 'f'},
+         {"idle-events", required_argument, nullptr, 'n'},
+         {"idle-interval", required_argument, nullptr, 'i'},
+         {"trace", required_argument, nullptr, 'T'},
+         {"metrics-socket", required_argument, nullptr, 'm'},
+         {"record", required_argument, nullptr, 'R'},
+         {"replay", required_argument, nullptr, 'P'},
          {nullptr, 0, nullptr, 0}}};
 
     try {
-      switch (getopt_long(argc, argv, "hc:w:", kLongOptions.data(), nullptr)) {
+      switch (getopt_long(argc, argv, "hc:w:b:prt:s:fn:i:T:m:R:P:",
+                          kLongOptions.data(), nullptr)) {
         case -1:
           return;
         case 'h':
@@ -79,6 +112,45 @@ void CommandLine::Init(int argc, char** argv) {
         case 'w':
           border_width_ = ParseInt<uint16_t>(optarg, std::dec);
           break;
+        case 'b':
+          border_strategy_ = ParseBorderStrategy(optarg);
+          break;
+        case 'p':
+          startup_profile_ = true;
+          break;
+        case 'r':
+          request_stats_ = true;
+          break;
+        case 't':
+          request_timeout_ = std::chrono::milliseconds{
+              ParseInt<uint32_t>(optarg, std::dec)};
+          break;
+        case 's':
+          stall_threshold_ = std::chrono::milliseconds{
+              ParseInt<uint32_t>(optarg, std::dec)};
+          break;
+        case 'f':
+          frame_pacing_ = true;
+          break;
+        case 'n':
+          idle_event_limit_ = ParseInt<uint32_t>(optarg, std::dec);
+          break;
+        case 'i':
+          idle_time_limit_ = std::chrono::microseconds{
+              ParseInt<uint32_t>(optarg, std::dec)};
+          break;
+        case 'T':
+          trace_file_ = optarg;
+          break;
+        case 'm':
+          metrics_socket_ = optarg;
+          break;
+        case 'R':
+          record_file_ = optarg;
+          break;
+        case 'P':
+          replay_file_ = optarg;
+          break;
         case '?':
           // getopt_long() already prints an error mesage indicating the
           // argument.
@@ -17,7 +17,17 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <string>
+
+// How the border is drawn.
+enum class BorderStrategy {
+  // One override-redirect window, shaped to its edges.
+  kShape,
+  // Four unshaped override-redirect windows, one per edge.
+  kEdges,
+};
 
 class CommandLine {
  public:
@@ -25,10 +35,54 @@ class CommandLine {
 
   [[nodiscard]] auto border_color() const -> uint32_t { return border_color_; }
   [[nodiscard]] auto border_width() const -> uint16_t { return border_width_; }
+  [[nodiscard]] auto border_strategy() const -> BorderStrategy {
+    return border_strategy_;
+  }
+  [[nodiscard]] auto startup_profile() const -> bool {
+    return startup_profile_;
+  }
+  [[nodiscard]] auto request_stats() const -> bool { return request_stats_; }
+  [[nodiscard]] auto frame_pacing() const -> bool { return frame_pacing_; }
+  [[nodiscard]] auto idle_event_limit() const -> uint32_t {
+    return idle_event_limit_;
+  }
+  [[nodiscard]] auto idle_time_limit() const -> std::chrono::microseconds {
+    return idle_time_limit_;
+  }
+  [[nodiscard]] auto request_timeout() const -> std::chrono::milliseconds {
+    return request_timeout_;
+  }
+  [[nodiscard]] auto stall_threshold() const -> std::chrono::milliseconds {
+    return stall_threshold_;
+  }
+  [[nodiscard]] auto trace_file() const -> const std::string& {
+    return trace_file_;
+  }
+  [[nodiscard]] auto metrics_socket() const -> const std::string& {
+    return metrics_socket_;
+  }
+  [[nodiscard]] auto record_file() const -> const std::string& {
+    return record_file_;
+  }
+  [[nodiscard]] auto replay_file() const -> const std::string& {
+    return replay_file_;
+  }
 
  private:
   void Init(int argc, char** argv);
 
   uint32_t border_color_;
   uint16_t border_width_;
+  BorderStrategy border_strategy_ = BorderStrategy::kShape;
+  bool startup_profile_ = false;
+  bool request_stats_ = false;
+  bool frame_pacing_ = false;
+  std::chrono::milliseconds request_timeout_;
+  std::chrono::milliseconds stall_threshold_;
+  uint32_t idle_event_limit_;
+  std::chrono::microseconds idle_time_limit_;
+  std::string trace_file_;
+  std::string metrics_socket_;
+  std::string record_file_;
+  std::string replay_file_;
 };
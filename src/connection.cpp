@@ -17,15 +17,32 @@
 
 #include "connection.h"
 
+#include <poll.h>
 #include <xcb/xcb.h>
+#include <xcb/xcbext.h>
 
-#include <array>
+#include <algorithm>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "command_line.h"
+#include "in_process_server.h"
+#include "p_error.h"
+#include "probes.h"
+#include "recorder.h"
+#include "timeout_error.h"
+#include "tracer.h"
+
 namespace {
 
+// Returns true iff request number |a| was sent before request number |b|,
+// accounting for wraparound.
+auto SequenceBefore(uint32_t a, uint32_t b) -> bool {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
 auto ScreenOfConnection(xcb_connection_t* c, int screen) -> xcb_screen_t* {
   xcb_screen_iterator_t iter;
 
@@ -39,72 +56,51 @@ auto ScreenOfConnection(xcb_connection_t* c, int screen) -> xcb_screen_t* {
   return nullptr;
 }
 
-void SetEventMask(xcb_connection_t* connection,
-                  const xcb_window_t& window,
-                  uint32_t new_mask) {
-  auto cookie = xcb_change_window_attributes(connection, window,
-                                             XCB_CW_EVENT_MASK, &new_mask);
-  // Window |window| may already be destroyed at this point, so the
-  // change_attributes request may give a BadWindow error.  In this case, just
-  // ignore the error.
-  xcb_discard_reply(connection, cookie.sequence);
+auto ToMilliseconds(Connection::Clock::duration duration)
+    -> std::chrono::milliseconds {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration);
 }
 
-}  // namespace
-
-class Connection::MultiMask {
- public:
-  MultiMask() = default;
+auto DeadlineBefore(const std::unique_ptr<ReplyHandler>& a,
+                    const std::unique_ptr<ReplyHandler>& b) -> bool {
+  return a->deadline() < b->deadline();
+}
 
-  ~MultiMask() = default;
+void LogStall(const RequestSite& site,
+              Connection::Clock::duration stalled,
+              bool finished) {
+  std::cerr << "Request " << site.request << " from " << site.file << ":"
+            << site.line << (finished ? " stalled" : " is stalling")
+            << " the event loop for " << ToMilliseconds(stalled).count()
+            << " ms" << std::endl;
+}
 
-  void AddMask(uint32_t mask) {
-    uint32_t mask_bit = 1;
-    for (auto& mask_count : mask_counts_) {
-      if ((mask & mask_bit) != XCB_EVENT_MASK_NO_EVENT) {
-        mask_count++;
-      }
-      mask_bit <<= 1U;
-    }
-  }
+// Async replies do not block the event loop, but a slow one still
+// delays whatever is waiting on it.
+void LogSlowReply(const RequestSite& site, Connection::Clock::duration waited) {
+  std::cerr << "Reply to request " << site.request << " from " << site.file
+            << ":" << site.line << " arrived after "
+            << ToMilliseconds(waited).count() << " ms" << std::endl;
+}
 
-  void RemoveMask(uint32_t mask) {
-    uint32_t mask_bit = 1;
-    for (auto& mask_count : mask_counts_) {
-      if ((mask & mask_bit) != XCB_EVENT_MASK_NO_EVENT) {
-        DCHECK(mask_count > 0);
-        mask_count--;
-      }
-      mask_bit <<= 1U;
-    }
-  }
+}  // namespace
 
-  [[nodiscard]] auto ToMask() const -> uint32_t {
-    uint32_t mask = XCB_EVENT_MASK_NO_EVENT;
-    uint32_t mask_bit = 1;
-    for (auto mask_count : mask_counts_) {
-      if (mask_count > 0) {
-        mask |= mask_bit;
-      }
-      mask_bit <<= 1U;
-    }
-    return mask;
+Connection::Connection(CommandLine* command_line, InProcessServer* server)
+    : server_(server),
+      request_timeout_(command_line->request_timeout()),
+      stall_threshold_(command_line->stall_threshold()) {
+  int screen_number = 0;
+  if (server_ != nullptr) {
+    connection_ = xcb_connect_to_fd(server_->TakeClientFd(), nullptr);
+  } else {
+    connection_ = xcb_connect(nullptr, &screen_number);
   }
-
- private:
-  static constexpr auto kMaskSize = 25;
-
-  std::array<unsigned int, kMaskSize> mask_counts_;
-
-  DELETE_SPECIAL_MEMBERS(MultiMask);
-};
-
-Connection::Connection() {
-  int screen_number;
-  connection_ = xcb_connect(nullptr, &screen_number);
   if (int error = xcb_connection_has_error(connection_)) {
     throw XError("XCB connection error code " + std::to_string(error));
   }
+  if (auto* recorder = Recorder::Get()) {
+    recorder->RecordSetup(*xcb_get_setup(connection_));
+  }
 
   xcb_screen_t* screen = ScreenOfConnection(connection_, screen_number);
   if (screen == nullptr) {
@@ -117,44 +113,229 @@ Connection::Connection() {
 }
 
 Connection::~Connection() {
-  for (const auto& mask_pair : mask_map_) {
-    SetEventMask(connection_, mask_pair.first, XCB_EVENT_MASK_NO_EVENT);
-  }
+  masks_.ForEach([this](xcb_window_t window, const WindowEventMask& mask) {
+    if (mask.committed != XCB_EVENT_MASK_NO_EVENT) {
+      SetEventMask(window, XCB_EVENT_MASK_NO_EVENT);
+    }
+  });
   xcb_flush(connection_);
   xcb_disconnect(connection_);
 }
 
+void Connection::SetEventMask(xcb_window_t window, uint32_t event_mask) {
+  request_stats_.RecordRequest(REQUEST_SITE(xcb_change_window_attributes));
+  auto cookie = xcb_change_window_attributes(connection_, window,
+                                             XCB_CW_EVENT_MASK, &event_mask);
+  // Window |window| may already be destroyed at this point, so the
+  // change_attributes request may give a BadWindow error.  In this case, just
+  // ignore the error.
+  xcb_discard_reply(connection_, cookie.sequence);
+}
+
 auto Connection::GenerateId() -> uint32_t {
   return xcb_generate_id(connection_);
 }
 
+auto Connection::ExtensionData(xcb_extension_t* extension)
+    -> const xcb_query_extension_reply_t* {
+  const auto* reply = xcb_get_extension_data(connection_, extension);
+  if (auto* recorder = Recorder::Get();
+      recorder != nullptr && reply != nullptr) {
+    recorder->RecordExtension(extension->name, *reply);
+  }
+  return reply;
+}
+
 void Connection::SelectEvents(xcb_window_t window, uint32_t event_mask) {
-  std::unique_ptr<MultiMask>& mask = mask_map_[window];
-  if (!mask) {
-    mask = std::make_unique<MultiMask>();
+  PROBE2(select__events, window, event_mask);
+  WindowEventMask* mask = masks_.FindOrInsert(window);
+  mask->requested.AddMask(event_mask);
+  uint32_t new_mask = mask->requested.ToMask();
+  // Newly selected events are committed immediately: callers rely on them
+  // being selected before any request they send next, e.g. querying the
+  // geometry of a window after selecting StructureNotify on it.
+  if ((new_mask & ~mask->committed) != XCB_EVENT_MASK_NO_EVENT) {
+    SetEventMask(window, new_mask);
+    mask->committed = new_mask;
   }
-  uint32_t old_mask = mask_map_[window]->ToMask();
-  mask->AddMask(event_mask);
-  AfterMaskChanged(window, old_mask);
 }
 
 void Connection::DeselectEvents(xcb_window_t window, uint32_t event_mask) {
-  DCHECK(mask_map_.find(window) != mask_map_.end());
-  std::unique_ptr<MultiMask>& mask = mask_map_[window];
-  uint32_t old_mask = mask->ToMask();
-  mask->RemoveMask(event_mask);
-  AfterMaskChanged(window, old_mask);
+  PROBE2(deselect__events, window, event_mask);
+  WindowEventMask* mask = masks_.Find(window);
+  DCHECK(mask);
+  mask->requested.RemoveMask(event_mask);
+  // Deselection is deferred to CommitEventMasks() so that events which
+  // are deselected and then reselected in the same loop iteration cost
+  // no requests.
+  if (!mask->dirty) {
+    mask->dirty = true;
+    dirty_windows_.push_back(window);
+  }
+}
+
+void Connection::CommitEventMasks() {
+  for (xcb_window_t window : dirty_windows_) {
+    WindowEventMask* mask = masks_.Find(window);
+    DCHECK(mask);
+    mask->dirty = false;
+    uint32_t new_mask = mask->requested.ToMask();
+    if (new_mask != mask->committed) {
+      SetEventMask(window, new_mask);
+      mask->committed = new_mask;
+    }
+    if (new_mask == XCB_EVENT_MASK_NO_EVENT) {
+      masks_.Erase(window);
+    }
+  }
+  dirty_windows_.clear();
+}
+
+auto Connection::AddReplyHandler(std::unique_ptr<ReplyHandler> handler)
+    -> AsyncRequest {
+  request_stats_.RecordRequest(handler->site());
+  ExpectReply(handler->sequence());
+  AsyncRequest request(handler.get());
+  reply_handlers_.push_back(std::move(handler));
+  return request;
+}
+
+auto Connection::ProcessReplies() -> bool {
+  bool processed = false;
+  while (!reply_handlers_.empty() && ProcessFrontReply()) {
+    processed = true;
+  }
+  return processed;
+}
+
+auto Connection::ProcessRepliesBefore(uint32_t full_sequence) -> bool {
+  // The server sends a reply before any event generated after the
+  // request was processed, so these replies have already been read.
+  bool processed = false;
+  while (!reply_handlers_.empty() &&
+         !SequenceBefore(full_sequence, reply_handlers_.front()->sequence()) &&
+         ProcessFrontReply()) {
+    processed = true;
+  }
+  return processed;
+}
+
+auto Connection::ProcessFrontReply() -> bool {
+  void* reply = nullptr;
+  xcb_generic_error_t* error = nullptr;
+  if (xcb_poll_for_reply(connection_, reply_handlers_.front()->sequence(),
+                         &reply, &error) == 0) {
+    return false;
+  }
+  auto handler = std::move(reply_handlers_.front());
+  reply_handlers_.pop_front();
+  if (auto* recorder = Recorder::Get();
+      recorder != nullptr && (reply != nullptr || error != nullptr)) {
+    recorder->RecordReply(handler->sequence(), reply, error);
+  }
+  if (error != nullptr) {
+    request_stats_.RecordError(handler->site());
+  } else if (reply != nullptr) {
+    request_stats_.RecordReply(handler->site());
+  }
+  if (auto waited = Clock::now() - handler->start();
+      waited >= stall_threshold_) {
+    LogSlowReply(handler->site(), waited);
+  }
+  handler->Complete(reply, error);
+  return true;
 }
 
-void Connection::AfterMaskChanged(xcb_window_t window, uint32_t old_mask) {
-  uint32_t new_mask = mask_map_[window]->ToMask();
-  if (new_mask == old_mask) {
-    return;
+auto Connection::ExpireReply() -> bool {
+  auto now = Clock::now();
+  auto it = std::min_element(reply_handlers_.begin(), reply_handlers_.end(),
+                             DeadlineBefore);
+  if (it == reply_handlers_.end() || (*it)->deadline() > now) {
+    return false;
   }
+  auto handler = std::move(*it);
+  reply_handlers_.erase(it);
+  xcb_discard_reply(connection_, handler->sequence());
+  request_stats_.RecordTimeout(handler->site());
+  handler->Expire();
+  return true;
+}
+
+auto Connection::NextReplyDeadline() const
+    -> std::optional<Clock::time_point> {
+  auto it = std::min_element(reply_handlers_.begin(), reply_handlers_.end(),
+                             DeadlineBefore);
+  if (it == reply_handlers_.end()) {
+    return std::nullopt;
+  }
+  return (*it)->deadline();
+}
 
-  SetEventMask(connection_, window, new_mask);
+auto Connection::WaitForReply(unsigned int sequence,
+                              const RequestSite& site,
+                              std::chrono::milliseconds timeout,
+                              xcb_generic_error_t** error) -> void* {
+  TRACE_SPAN("sync", site.request);
+  PROBE2(sync__begin, site.request, sequence);
+  ExpectReply(sequence);
+  xcb_flush(connection_);
+  request_stats_.RecordRequest(site);
+
+  const auto start = Clock::now();
+  const auto deadline = start + timeout;
+  bool stalled = false;
+  void* reply = nullptr;
+  while (xcb_poll_for_reply(connection_, sequence, &reply, error) == 0) {
+    auto now = Clock::now();
+    if (!stalled && now - start >= stall_threshold_) {
+      stalled = true;
+      LogStall(site, now - start, false);
+    }
+    if (now >= deadline) {
+      xcb_discard_reply(connection_, sequence);
+      request_stats_.RecordSyncWait(site, now - start);
+      request_stats_.RecordTimeout(site);
+      throw TimeoutError(site, ToMilliseconds(now - start));
+    }
 
-  if (new_mask == XCB_EVENT_MASK_NO_EVENT) {
-    mask_map_.erase(window);
+    auto wake =
+        stalled ? deadline : std::min(deadline, start + stall_threshold_);
+    // Round up so that the loop does not spin when less than a
+    // millisecond remains.
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(wake - now);
+    struct pollfd poll_fd {
+      xcb_get_file_descriptor(connection_), POLLIN, 0
+    };
+    if (REDO_ON_EINTR(poll(&poll_fd, 1, CheckedCast<int>(wait.count()))) ==
+        -1) {
+      throw PError("poll");
+    }
+  }
+  const auto waited = Clock::now() - start;
+  if (auto* recorder = Recorder::Get();
+      recorder != nullptr && (reply != nullptr || *error != nullptr)) {
+    recorder->RecordReply(sequence, reply, *error);
+  }
+  request_stats_.RecordSyncWait(site, waited);
+  if (*error != nullptr) {
+    request_stats_.RecordError(site);
+  } else if (reply != nullptr) {
+    request_stats_.RecordReply(site);
+  }
+  if (stalled) {
+    LogStall(site, waited, true);
+  }
+  PROBE3(sync__end, site.request, sequence,
+         std::chrono::duration_cast<std::chrono::microseconds>(waited)
+             .count());
+  return reply;
+}
+
+void Connection::ExpectReply(uint32_t sequence) {
+  if (auto* recorder = Recorder::Get()) {
+    recorder->RecordExpectReply(sequence);
+  }
+  if (server_ != nullptr) {
+    server_->ExpectReply(sequence);
   }
 }
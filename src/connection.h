@@ -20,54 +20,185 @@
 #include <xcb/xcb.h>
 #include <xcb/xproto.h>
 
+#include <chrono>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <type_traits>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "async_request.h"
+#include "event_mask_table.h"
+#include "request_site.h"
+#include "request_stats.h"
 #include "util.h"
 #include "x_error.h"
 
-#define XCB_SYNC(func, c, ...)  \
-  XcbSyncAux((c), func##_reply, \
+class CommandLine;
+class InProcessServer;
+
+// Sends a request and waits for its reply.  Throws TimeoutError if the
+// reply does not arrive within the connection's request timeout.
+#define XCB_SYNC(func, c, ...)                   \
+  XCB_SYNC_TIMEOUT((c)->request_timeout(), func, \
+                   c __VA_OPT__(, ) __VA_ARGS__)
+
+// Like XCB_SYNC, but with a |timeout| for this call site.
+#define XCB_SYNC_TIMEOUT(timeout, func, c, ...)                \
+  XcbSyncAux((c), REQUEST_SITE(func), (timeout), func##_reply, \
              func((c)->connection() __VA_OPT__(, ) __VA_ARGS__))
 
+// Waits for the reply to a request that was already sent.
+#define XCB_REPLY(func, c, cookie)                                          \
+  XcbSyncAux((c), REQUEST_SITE(func), (c)->request_timeout(), func##_reply, \
+             (cookie))
+
+// Sends a request that has no reply.  Like every other request, it is
+// counted in request_stats().
+#define XCB_VOID(func, c, ...)                          \
+  ((c)->RecordRequest(REQUEST_SITE(func)),              \
+   func((c)->connection() __VA_OPT__(, ) __VA_ARGS__))
+
+// Sends a request and returns an AsyncRequest without waiting for the
+// reply.  |callback| is run with the reply from the event loop.  If the
+// reply does not arrive within the connection's request timeout, a
+// TimeoutError is reported instead.
+#define XCB_ASYNC(func, c, callback, ...)                                   \
+  XcbAsyncAux((c), REQUEST_SITE(func), (c)->request_timeout(), func##_reply, \
+              func((c)->connection() __VA_OPT__(, ) __VA_ARGS__), (callback))
+
+// Handles the reply to a request that was already sent asynchronously.
+#define XCB_ASYNC_REPLY(func, c, cookie, callback)                           \
+  XcbAsyncAux((c), REQUEST_SITE(func), (c)->request_timeout(), func##_reply, \
+              (cookie), (callback))
+
 template <typename T>
 using XcbReply = std::unique_ptr<T, FreeDeleter>;
 
 class Connection {
  public:
-  Connection();
+  using Clock = std::chrono::steady_clock;
+
+  // Connects to |server| instead of the X server if it is not null.
+  Connection(CommandLine* command_line, InProcessServer* server);
   ~Connection();
 
   auto GenerateId() -> uint32_t;
+
+  // Returns the QueryExtension reply for |extension|, waiting for it if
+  // it was not prefetched.
+  auto ExtensionData(xcb_extension_t* extension)
+      -> const xcb_query_extension_reply_t*;
+
   void SelectEvents(xcb_window_t window, uint32_t event_mask);
   void DeselectEvents(xcb_window_t window, uint32_t event_mask);
 
+  // Sends the event masks of windows whose events were deselected since
+  // the last commit, if they differ from what the server last received.
+  // Called once per event loop iteration, before flushing.
+  void CommitEventMasks();
+
+  auto AddReplyHandler(std::unique_ptr<ReplyHandler> handler) -> AsyncRequest;
+
+  // Runs the callbacks of asynchronous requests whose replies have
+  // arrived, in the order the requests were sent.  Returns true iff any
+  // reply was handled.  If a callback throws, the remaining replies are
+  // left for the next call.
+  auto ProcessReplies() -> bool;
+
+  // Like ProcessReplies(), but only handles replies to requests that the
+  // server processed before generating the event with |full_sequence|.
+  auto ProcessRepliesBefore(uint32_t full_sequence) -> bool;
+
+  // Drops the outstanding asynchronous request with the earliest passed
+  // deadline, if any, and throws TimeoutError unless it was cancelled.
+  // Returns true iff a request was dropped.
+  auto ExpireReply() -> bool;
+
+  // Returns the earliest deadline of any outstanding asynchronous request.
+  [[nodiscard]] auto NextReplyDeadline() const
+      -> std::optional<Clock::time_point>;
+
+  // Waits for the reply to request |sequence|, logging a warning if the
+  // wait exceeds the stall threshold.  Returns the reply, or null if
+  // |error| was set.  Throws TimeoutError if |timeout| passes first.
+  auto WaitForReply(unsigned int sequence,
+                    const RequestSite& site,
+                    std::chrono::milliseconds timeout,
+                    xcb_generic_error_t** error) -> void*;
+
   auto connection() const -> xcb_connection_t* { return connection_; }
   auto root_window() const -> xcb_window_t { return root_window_; }
+  auto request_timeout() const -> std::chrono::milliseconds {
+    return request_timeout_;
+  }
+  auto request_stats() const -> const RequestStats& { return request_stats_; }
+
+  // Counts a request that was sent without going through Connection.
+  void RecordRequest(const RequestSite& site) {
+    request_stats_.RecordRequest(site);
+  }
 
  private:
-  class MultiMask;
+  void SetEventMask(xcb_window_t window, uint32_t event_mask);
+
+  auto ProcessFrontReply() -> bool;
 
-  void AfterMaskChanged(xcb_window_t window, uint32_t old_mask);
+  // Called when the reply to request |sequence| is first waited for or
+  // handed to a ReplyHandler, so that recordings can be played back.
+  void ExpectReply(uint32_t sequence);
 
+  InProcessServer* server_;
   xcb_connection_t* connection_;
   xcb_window_t root_window_;
 
-  std::unordered_map<xcb_window_t, std::unique_ptr<MultiMask>> mask_map_;
+  std::chrono::milliseconds request_timeout_;
+  std::chrono::milliseconds stall_threshold_;
+
+  EventMaskTable masks_;
+  std::vector<xcb_window_t> dirty_windows_;
+
+  std::deque<std::unique_ptr<ReplyHandler>> reply_handlers_;
+
+  RequestStats request_stats_;
 
   DELETE_SPECIAL_MEMBERS(Connection);
 };
 
 template <typename Cookie, typename ReplyFunc>
-auto XcbSyncAux(Connection* connection, ReplyFunc reply_func, Cookie cookie)
-    -> decltype(auto) {
+using XcbReplyType = std::remove_pointer_t<std::invoke_result_t<
+    ReplyFunc, xcb_connection_t*, Cookie, xcb_generic_error_t**>>;
+
+template <typename Cookie, typename ReplyFunc>
+auto XcbSyncAux(Connection* connection,
+                const RequestSite& site,
+                std::chrono::milliseconds timeout,
+                ReplyFunc /*reply_func*/,
+                Cookie cookie) -> decltype(auto) {
+  using Reply = XcbReplyType<Cookie, ReplyFunc>;
   xcb_generic_error_t* error = nullptr;
-  auto* t = reply_func(connection->connection(), cookie, &error);
+  XcbReply<Reply> reply(static_cast<Reply*>(
+      connection->WaitForReply(cookie.sequence, site, timeout, &error)));
   if (error) {
-    throw XError(*error);
+    XcbReply<xcb_generic_error_t> owned_error(error);
+    throw XError(*owned_error);
   }
-  DCHECK(t);
-  return XcbReply<std::decay_t<decltype(*t)>>(t);
+  if (!reply) {
+    throw XError("Connection closed before reply was received");
+  }
+  return reply;
+}
+
+template <typename Cookie, typename ReplyFunc, typename Callback>
+auto XcbAsyncAux(Connection* connection,
+                 const RequestSite& site,
+                 std::chrono::milliseconds timeout,
+                 ReplyFunc /*reply_func*/,
+                 Cookie cookie,
+                 Callback callback) -> AsyncRequest {
+  using Reply = XcbReplyType<Cookie, ReplyFunc>;
+  return connection->AddReplyHandler(std::make_unique<TypedReplyHandler<Reply>>(
+      cookie.sequence, site, timeout, std::move(callback)));
 }
@@ -0,0 +1,64 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "dispatch_stats.h"
+
+#include <cstddef>
+
+#include "util.h"
+
+void DispatchStats::Record(EventPriority priority,
+                           std::chrono::nanoseconds delay) {
+  queueing_delays_[static_cast<std::size_t>(priority)].Record(delay);
+}
+
+void DispatchStats::RecordDispatch(uint8_t response_type,
+                                   std::chrono::nanoseconds duration) {
+  DCHECK(response_type < kNumResponseTypes);
+  dispatched_[response_type]++;
+  dispatch_time_.Record(duration);
+}
+
+void DispatchStats::RecordForcedIdle(IdleBound bound) {
+  if (bound == IdleBound::kEvents) {
+    forced_idle_by_events_++;
+  } else {
+    forced_idle_by_time_++;
+  }
+}
+
+void DispatchStats::Print(std::ostream& stream) const {
+  for (std::size_t i = 0; i < kNumEventPriorities; i++) {
+    const auto& delay = queueing_delays_[i];
+    stream << EventPriorityName(static_cast<EventPriority>(i))
+           << " events: dispatched=" << delay.count();
+    if (delay.count() > 0) {
+      stream << " queueing_delay_us(p50<" << delay.Quantile(0.5)
+             << " p99<" << delay.Quantile(0.99) << " max<"
+             << delay.Quantile(1.0) << ")";
+    }
+    stream << '\n';
+  }
+  if (dispatch_time_.count() > 0) {
+    stream << "dispatch_us(p50<" << dispatch_time_.Quantile(0.5)
+           << " p99<" << dispatch_time_.Quantile(0.99) << " max<"
+           << dispatch_time_.Quantile(1.0) << ")\n";
+  }
+  stream << "forced idle passes: event_limit=" << forced_idle_by_events_
+         << " time_limit=" << forced_idle_by_time_ << '\n';
+  stream.flush();
+}
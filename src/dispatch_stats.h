@@ -0,0 +1,74 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "event_priority.h"
+#include "histogram.h"
+
+// How long events of each priority class waited between being drained
+// from XCB into a batch and being dispatched, how many events of each
+// type were dispatched and how long that took, and how often an event
+// flood forced an idle pass.
+class DispatchStats {
+ public:
+  enum class IdleBound {
+    kEvents,
+    kTime,
+  };
+
+  // Response types with the send-event bit cleared.
+  static constexpr std::size_t kNumResponseTypes = 128;
+
+  void Record(EventPriority priority, std::chrono::nanoseconds delay);
+  void RecordDispatch(uint8_t response_type,
+                      std::chrono::nanoseconds duration);
+  void RecordForcedIdle(IdleBound bound);
+
+  [[nodiscard]] auto queueing_delay(EventPriority priority) const
+      -> const Histogram& {
+    return queueing_delays_[static_cast<std::size_t>(priority)];
+  }
+
+  [[nodiscard]] auto dispatched(uint8_t response_type) const -> uint64_t {
+    return dispatched_[response_type];
+  }
+
+  // How long handlers took to run for each dispatched event.
+  [[nodiscard]] auto dispatch_time() const -> const Histogram& {
+    return dispatch_time_;
+  }
+
+  [[nodiscard]] auto forced_idle_passes(IdleBound bound) const -> uint64_t {
+    return bound == IdleBound::kEvents ? forced_idle_by_events_
+                                       : forced_idle_by_time_;
+  }
+
+  void Print(std::ostream& stream) const;
+
+ private:
+  std::array<Histogram, kNumEventPriorities> queueing_delays_;
+  std::array<uint64_t, kNumResponseTypes> dispatched_{};
+  Histogram dispatch_time_;
+  uint64_t forced_idle_by_events_ = 0;
+  uint64_t forced_idle_by_time_ = 0;
+};
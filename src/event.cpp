@@ -17,6 +17,8 @@
 
 #include "event.h"
 
+#include <utility>
+
 namespace {
 
 constexpr const uint8_t kSendEventMask = 0x80U;
@@ -25,12 +27,36 @@ constexpr const uint8_t kResponseTypeMask =
 
 }  // namespace
 
-Event::Event(xcb_generic_event_t* event) : event_(event) {}
+auto IsSendEvent(uint8_t response_type) -> bool {
+  return (response_type & kSendEventMask) != 0;
+}
+
+Event::Event(xcb_generic_event_t* event)
+    : Event(event, std::unique_ptr<xcb_generic_event_t, FreeDeleter>(event)) {}
+
+Event::Event(const xcb_generic_event_t* event,
+             std::unique_ptr<xcb_generic_event_t, FreeDeleter> owned_event)
+    : event_(event), owned_event_(std::move(owned_event)) {}
 
 Event::~Event() = default;
 
+Event::Event(Event&& other) noexcept
+    : event_(std::exchange(other.event_, nullptr)),
+      owned_event_(std::move(other.owned_event_)) {}
+
+auto Event::operator=(Event&& other) noexcept -> Event& {
+  event_ = std::exchange(other.event_, nullptr);
+  owned_event_ = std::move(other.owned_event_);
+  return *this;
+}
+
+// static
+auto Event::Borrow(const xcb_generic_event_t* event) -> Event {
+  return Event(event, nullptr);
+}
+
 auto Event::SendEvent() const -> bool {
-  return (event_->response_type & kSendEventMask) != 0;
+  return IsSendEvent(event_->response_type);
 }
 
 auto Event::ResponseType() const -> uint8_t {
@@ -25,23 +25,41 @@
 
 #include "util.h"
 
+// Returns true iff the event was sent with SendEvent rather than
+// generated by the server.
+auto IsSendEvent(uint8_t response_type) -> bool;
+
 class Event {
  public:
   // Takes ownership of |event|.
   explicit Event(xcb_generic_event_t* event);
   ~Event();
 
+  // Refers to |event| without owning it.  |event| must outlive the
+  // returned Event.
+  static auto Borrow(const xcb_generic_event_t* event) -> Event;
+
+  // Leave |other| empty.
+  Event(Event&& other) noexcept;
+  auto operator=(Event&& other) noexcept -> Event&;
+  Event(const Event&) = delete;
+  auto operator=(const Event&) -> Event& = delete;
+
   [[nodiscard]] auto SendEvent() const -> bool;
   [[nodiscard]] auto ResponseType() const -> uint8_t;
   [[nodiscard]] auto Sequence() const -> uint16_t;
 
   explicit operator bool() const { return event_ != nullptr; }
   [[nodiscard]] auto event() const -> const xcb_generic_event_t* {
-    return event_.get();
+    return event_;
   }
 
  private:
-  std::unique_ptr<xcb_generic_event_t, FreeDeleter> event_;
+  Event(const xcb_generic_event_t* event,
+        std::unique_ptr<xcb_generic_event_t, FreeDeleter> owned_event);
+
+  const xcb_generic_event_t* event_;
 
-  DELETE_SPECIAL_MEMBERS(Event);
+  // Null unless this Event owns |event_|.
+  std::unique_ptr<xcb_generic_event_t, FreeDeleter> owned_event_;
 };
@@ -0,0 +1,174 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "event_batch.h"
+
+#include <xcb/xproto.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include "dispatch_stats.h"
+#include "event_router.h"
+
+namespace {
+
+auto StructureEventWindow(const Event& event) -> xcb_window_t {
+  const auto* raw = event.event();
+  switch (event.ResponseType()) {
+    case XCB_CIRCULATE_NOTIFY:
+      return reinterpret_cast<const xcb_circulate_notify_event_t*>(raw)->event;
+    case XCB_DESTROY_NOTIFY:
+      return reinterpret_cast<const xcb_destroy_notify_event_t*>(raw)->event;
+    case XCB_MAP_NOTIFY:
+      return reinterpret_cast<const xcb_map_notify_event_t*>(raw)->event;
+    case XCB_REPARENT_NOTIFY:
+      return reinterpret_cast<const xcb_reparent_notify_event_t*>(raw)->event;
+    case XCB_UNMAP_NOTIFY:
+      return reinterpret_cast<const xcb_unmap_notify_event_t*>(raw)->event;
+    default:
+      return XCB_WINDOW_NONE;
+  }
+}
+
+}  // namespace
+
+EventBatch::EventBatch(const EventRouter* router, DispatchStats* stats)
+    : router_(router), stats_(stats) {
+  events_.reserve(kMaxEvents);
+  superseders_.reserve(kMaxEvents);
+}
+
+EventBatch::~EventBatch() = default;
+
+void EventBatch::Fill(xcb_connection_t* connection,
+                      xcb_generic_event_t* first) {
+  DCHECK(empty());
+  events_.clear();
+  next_ = 0;
+
+  fill_time_ = std::chrono::steady_clock::now();
+
+  events_.push_back({ring_.Store(first), EventPriority::kBulk});
+  while (events_.size() < kMaxEvents) {
+    auto* event = xcb_poll_for_queued_event(connection);
+    if (event == nullptr) {
+      break;
+    }
+    events_.push_back({ring_.Store(event), EventPriority::kBulk});
+  }
+  if (events_.size() > 1) {
+    Compress();
+  }
+  Prioritize();
+}
+
+auto EventBatch::Pop(uint32_t* reply_limit) -> Event {
+  DCHECK(!empty());
+  auto& entry = events_[next_++];
+  *reply_limit = entry.event.event()->full_sequence;
+  for (auto i = next_; i < events_.size(); i++) {
+    auto sequence = events_[i].event.event()->full_sequence;
+    if (static_cast<int32_t>(sequence - *reply_limit) < 0) {
+      *reply_limit = sequence;
+    }
+  }
+  stats_->Record(entry.priority, std::chrono::steady_clock::now() - fill_time_);
+  return std::move(entry.event);
+}
+
+void EventBatch::Compress() {
+  // Walk backwards so that each event is compared against what follows
+  // it.  Batches are a few dozen events, so a flat list beats a map.
+  auto& superseders = superseders_;
+  superseders.clear();
+  auto find = [&](xcb_window_t event, xcb_window_t window) {
+    return std::find_if(superseders.begin(), superseders.end(),
+                        [&](const Superseder& superseder) {
+                          return superseder.event == event &&
+                                 superseder.window == window;
+                        });
+  };
+
+  auto first_kept = events_.size();
+  for (auto i = events_.size(); i-- > 0;) {
+    const Event& event = events_[i].event;
+    auto type = event.ResponseType();
+    bool drop = false;
+    if (event.SendEvent()) {
+      // Synthetic events are never superseded and do not supersede.
+    } else if (type == XCB_CONFIGURE_NOTIFY) {
+      const auto* configure =
+          reinterpret_cast<const xcb_configure_notify_event_t*>(event.event());
+      auto it = find(configure->event, configure->window);
+      if (it == superseders.end()) {
+        superseders.push_back({configure->event, configure->window, true});
+      } else if (it->configure) {
+        drop = true;
+      } else {
+        it->configure = true;
+      }
+    } else if (type == XCB_GRAVITY_NOTIFY) {
+      const auto* gravity =
+          reinterpret_cast<const xcb_gravity_notify_event_t*>(event.event());
+      auto it = find(gravity->event, gravity->window);
+      if (it == superseders.end()) {
+        superseders.push_back({gravity->event, gravity->window, false});
+      } else {
+        drop = true;
+      }
+    } else if (auto window = StructureEventWindow(event);
+               window != XCB_WINDOW_NONE) {
+      superseders.erase(
+          std::remove_if(superseders.begin(), superseders.end(),
+                         [window](const Superseder& superseder) {
+                           return superseder.event == window;
+                         }),
+          superseders.end());
+    }
+
+    if (!drop) {
+      if (--first_kept != i) {
+        events_[first_kept] = std::move(events_[i]);
+      }
+    }
+  }
+
+  events_.erase(events_.begin(),
+                events_.begin() + static_cast<std::ptrdiff_t>(first_kept));
+}
+
+void EventBatch::Prioritize() {
+  for (auto& entry : events_) {
+    entry.priority = router_->PriorityOf(entry.event);
+  }
+
+  // Insertion sort is stable and does not allocate, unlike
+  // std::stable_sort, and batches are small and nearly sorted.
+  for (std::size_t i = 1; i < events_.size(); i++) {
+    if (events_[i - 1].priority <= events_[i].priority) {
+      continue;
+    }
+    auto entry = std::move(events_[i]);
+    auto j = i;
+    for (; j > 0 && events_[j - 1].priority > entry.priority; j--) {
+      events_[j] = std::move(events_[j - 1]);
+    }
+    events_[j] = std::move(entry);
+  }
+}
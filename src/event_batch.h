@@ -0,0 +1,104 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "event.h"
+#include "event_priority.h"
+#include "event_ring.h"
+#include "util.h"
+
+class DispatchStats;
+class EventRouter;
+
+// Events already read from the connection, dispatched by priority.
+// Refilling takes everything XCB has queued at once, up to kMaxEvents, so
+// that superseded geometry events can be dropped and input can overtake
+// bulk traffic before anyone handles them.
+class EventBatch {
+ public:
+  EventBatch(const EventRouter* router, DispatchStats* stats);
+  ~EventBatch();
+
+  [[nodiscard]] auto empty() const -> bool { return next_ == events_.size(); }
+
+  // Every event of a batch stays in the ring until it is popped, and the
+  // caller destroys each popped event before the batch is refilled.
+  static constexpr std::size_t kMaxEvents = EventRing::kSlots;
+
+  // Must only be called when empty().  Starts a batch with |first| and
+  // the events that XCB has already read after it.
+  void Fill(xcb_connection_t* connection, xcb_generic_event_t* first);
+
+  // Must not be called when empty().  Records how long the event waited
+  // in the batch.  Sets |reply_limit| to the last sequence number whose
+  // reply may be handled before the event: its own, or that of an older
+  // event it overtook, so that no reply newer than a pending event is
+  // applied before it.
+  [[nodiscard]] auto Pop(uint32_t* reply_limit) -> Event;
+
+ private:
+  // Drops each ConfigureNotify that is followed by another ConfigureNotify
+  // for the same window, and each GravityNotify that is followed by either,
+  // as long as no other structure event for the window comes in between.
+  void Compress();
+
+  // Stably sorts the batch by the priority of the handlers of each event.
+  // An event that overtakes others may lead to requests whose replies are
+  // newer than the events it overtook, e.g. when a new active window is
+  // tracked from scratch.  Handlers that take state from such replies
+  // must ignore events older than the request, as WindowGeometryTracker
+  // does.
+  void Prioritize();
+
+  struct Entry {
+    Event event;
+    EventPriority priority;
+  };
+
+  // Compression key of a structure event.  Both ConfigureNotify and
+  // GravityNotify start with the same fields, so |event| and |window|
+  // identify the recipient and the subject for either.
+  struct Superseder {
+    xcb_window_t event;
+    xcb_window_t window;
+
+    // True iff a later ConfigureNotify (as opposed to only a later
+    // GravityNotify) was seen.
+    bool configure;
+  };
+
+  const EventRouter* router_;
+  DispatchStats* stats_;
+
+  EventRing ring_;
+  std::vector<Entry> events_;
+  std::size_t next_ = 0;
+  std::chrono::steady_clock::time_point fill_time_;
+
+  // Scratch space for Compress(), kept to avoid allocating per batch.
+  std::vector<Superseder> superseders_;
+
+  DELETE_SPECIAL_MEMBERS(EventBatch);
+};
@@ -0,0 +1,109 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <cstdint>
+
+#include "event_priority.h"
+#include "event_route.h"
+#include "event_traits.h"
+
+// A member function that handles one kind of event, bound to its target
+// and to the route it is registered on.  The event is decoded to its
+// struct by a thunk generated for the handler, so handlers never inspect
+// the response type or cast the payload themselves.
+class EventHandler {
+ public:
+  using Thunk = void (*)(void* target, const xcb_generic_event_t& event);
+
+  // Handles the core events selected on |window| that |Method| accepts.
+  template <auto Method, typename Target>
+  static auto ForWindow(Target* target,
+                        xcb_window_t window,
+                        EventPriority priority = EventPriority::kBulk)
+      -> EventHandler {
+    using XEvent = typename EventHandlerMethodTraits<decltype(Method)>::Event;
+    return EventHandler(
+        EventRoute::ForWindow(EventTraits<XEvent>::kResponseType, window),
+        priority, EventTraits<XEvent>::kName, target,
+        &Call<Method, Target, XEvent>);
+  }
+
+  // Handles one generic event type of the extension with major opcode
+  // |extension|.
+  template <auto Method, typename Target>
+  static auto ForGenericEvent(Target* target,
+                              uint8_t extension,
+                              uint16_t event_type,
+                              EventPriority priority = EventPriority::kBulk)
+      -> EventHandler {
+    using XEvent = typename EventHandlerMethodTraits<decltype(Method)>::Event;
+    return EventHandler(EventRoute::ForGenericEvent(extension, event_type),
+                        priority, EventTraits<XEvent>::kName, target,
+                        &Call<Method, Target, XEvent>);
+  }
+
+  // Consumes events of type |XEvent| selected on |window| without doing
+  // anything, so that they are not reported as unhandled.
+  template <typename XEvent>
+  static auto Ignore(xcb_window_t window) -> EventHandler {
+    return EventHandler(
+        EventRoute::ForWindow(EventTraits<XEvent>::kResponseType, window),
+        EventPriority::kBulk, EventTraits<XEvent>::kName, nullptr,
+        [](void* /*target*/, const xcb_generic_event_t& /*event*/) {});
+  }
+
+  [[nodiscard]] auto route() const -> const EventRoute& { return route_; }
+  [[nodiscard]] auto priority() const -> EventPriority { return priority_; }
+
+  // The name of the event type, which names the handler's trace spans.
+  [[nodiscard]] auto name() const -> const char* { return name_; }
+
+  void Run(const xcb_generic_event_t& event) const { thunk_(target_, event); }
+
+  auto operator==(const EventHandler& other) const -> bool {
+    return route_ == other.route_ && target_ == other.target_ &&
+           thunk_ == other.thunk_;
+  }
+
+ private:
+  EventHandler(const EventRoute& route,
+               EventPriority priority,
+               const char* name,
+               void* target,
+               Thunk thunk)
+      : route_(route),
+        priority_(priority),
+        name_(name),
+        target_(target),
+        thunk_(thunk) {}
+
+  template <auto Method, typename Target, typename XEvent>
+  static void Call(void* target, const xcb_generic_event_t& event) {
+    (static_cast<Target*>(target)->*Method)(
+        reinterpret_cast<const XEvent&>(event));
+  }
+
+  EventRoute route_;
+  EventPriority priority_;
+  const char* name_;
+  void* target_;
+  Thunk thunk_;
+};
@@ -17,23 +17,32 @@
 
 #include "event_loop.h"
 
-#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
 #include <xcb/xcb.h>
 #include <xcb/xproto.h>
 
-#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <forward_list>
 #include <iostream>
 #include <sstream>  // IWYU pragma: keep (https://github.com/include-what-you-use/include-what-you-use/issues/277)
 #include <string>
 
+#include "allocation_counter.h"
+#include "command_line.h"
 #include "connection.h"
 #include "event.h"
-#include "event_dispatcher.h"
 #include "event_loop_idle_observer.h"
 #include "lippincott.h"
 #include "p_error.h"
+#include "probes.h"
+#include "recorder.h"
+#include "tracer.h"
 #include "util.h"
 
 namespace {
@@ -46,60 +55,237 @@ auto MakeUnhandledErrorMessage(const Event& event) -> std::string {
   return stream.str();
 }
 
+// Returns how long to block before the next asynchronous request expires,
+// or -1 to block indefinitely.
+auto PollTimeout(const Connection& connection) -> int {
+  auto deadline = connection.NextReplyDeadline();
+  if (!deadline) {
+    return -1;
+  }
+  auto timeout = std::chrono::ceil<std::chrono::milliseconds>(
+      *deadline - Connection::Clock::now());
+  return CheckedCast<int>(std::max<std::chrono::milliseconds::rep>(
+      timeout.count(), 0));
+}
+
 }  // namespace
 
-EventLoop::EventLoop(Connection* connection, int should_quit_fd)
-    : connection_(connection), should_quit_fd_(should_quit_fd) {}
+EventLoop::EventLoop(Connection* connection, CommandLine* command_line)
+    : connection_(connection),
+      connection_fd_(xcb_get_file_descriptor(connection_->connection())),
+      epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      max_events_between_idle_(command_line->idle_event_limit()),
+      max_time_between_idle_(command_line->idle_time_limit()),
+      batch_(&event_router_, &dispatch_stats_) {
+  if (epoll_fd_ == -1) {
+    throw PError("epoll_create1");
+  }
+  WatchFd(connection_fd_, &connection_watcher_, Trigger::kLevel);
+  WatchFd(timer_queue_.fd(), &timer_queue_);
+}
+
+EventLoop::~EventLoop() {
+  UnwatchFd(timer_queue_.fd());
+  UnwatchFd(connection_fd_);
+  DCHECK(watchers_.empty());
+  if (REDO_ON_EINTR(close(epoll_fd_) == -1)) {
+    perror("close");
+    std::abort();
+  }
+}
+
+void EventLoop::WatchFd(int fd, FdWatcher* watcher, Trigger trigger) {
+  struct epoll_event event {};
+  event.events = EPOLLIN;
+  if (trigger == Trigger::kEdge) {
+    event.events |= EPOLLET;
+  }
+  event.data.ptr = watcher;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+    throw PError("epoll_ctl");
+  }
+  watchers_.emplace_back(fd, watcher);
+}
+
+void EventLoop::UnwatchFd(int fd) {
+  auto it = std::find_if(watchers_.begin(), watchers_.end(),
+                         [fd](const auto& watch) { return watch.first == fd; });
+  DCHECK(it != watchers_.end());
+  FdWatcher* watcher = it->second;
+  watchers_.erase(it);
+
+  for (std::size_t i = 0; i < num_ready_fds_; i++) {
+    if (ready_fds_[i].data.ptr == watcher) {
+      ready_fds_[i].data.ptr = nullptr;
+    }
+  }
 
-EventLoop::~EventLoop() = default;
+  struct epoll_event event {};
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &event) == -1) {
+    perror("epoll_ctl");
+    std::abort();
+  }
+}
 
-void EventLoop::Run() const {
+void EventLoop::Run() {
+  PROBE(run__begin);
+  quit_ = false;
+  // Everything but events and replies is charged to the idle phase.
+  ScopedAllocationPhase idle_phase(AllocationPhase::kIdle);
   while (auto event = WaitForEvent()) {
-    bool dispatched = false;
-    for (auto* dispatcher : Observable<EventDispatcher>::observers()) {
-      try {
-        dispatched = dispatcher->DispatchEvent(event);
-      } catch (...) {
-        Lippincott();
-      }
-      if (dispatched) {
-        break;
-      }
+    const auto start = std::chrono::steady_clock::now();
+    bool handled;
+    {
+      ScopedAllocationPhase event_phase(AllocationPhase::kEvent);
+      handled = event_router_.Dispatch(event);
     }
-    if (!dispatched && event.ResponseType() != XCB_CLIENT_MESSAGE) {
+    dispatch_stats_.RecordDispatch(event.ResponseType(),
+                                   std::chrono::steady_clock::now() - start);
+    if (!handled && event.ResponseType() != XCB_CLIENT_MESSAGE) {
       std::cerr << MakeUnhandledErrorMessage(event) << std::endl;
     }
   }
+  PROBE(run__end);
 }
 
-auto EventLoop::WaitForEvent() const -> Event {
+auto EventLoop::WaitForEvent() -> Event {
   auto* connection = connection_->connection();
 
-  xcb_generic_event_t* event = xcb_poll_for_event(connection);
-  if ((event != nullptr) || (xcb_connection_has_error(connection) != 0)) {
-    return Event(event);
+  while (true) {
+    if (batch_.empty()) {
+      if (auto* event = xcb_poll_for_event(connection)) {
+        batch_.Fill(connection, event);
+      }
+    }
+    if (!batch_.empty()) {
+      if (IdleBoundReached()) {
+        // Let idle work, timers and signals through, then carry on with
+        // the flood.
+        RunIdlePass();
+        WaitForFds(0);
+        if (quit_) {
+          return Event(nullptr);
+        }
+      }
+      if (events_since_idle_++ == 0) {
+        busy_since_ = std::chrono::steady_clock::now();
+      }
+
+      uint32_t reply_limit;
+      auto event = batch_.Pop(&reply_limit);
+      PROBE2(event__popped, event.ResponseType(), event.Sequence());
+      // Replies to requests that were processed before |event| was
+      // generated must be handled first, or they would clobber any state
+      // that |event| updates with stale values.
+      ProcessReplies(
+          [&]() { return connection_->ProcessRepliesBefore(reply_limit); });
+      return event;
+    }
+    if (xcb_connection_has_error(connection) != 0) {
+      return Event(nullptr);
+    }
+
+    // Reading from the connection above may have also read replies.
+    if (ProcessReplies([&]() { return connection_->ProcessReplies(); })) {
+      continue;
+    }
+
+    if (ProcessReplies([&]() { return connection_->ExpireReply(); })) {
+      continue;
+    }
+
+    RunIdlePass();
+
+    if (quit_) {
+      return Event(nullptr);
+    }
+    // Write out trace spans and recorded packets while there is nothing
+    // else to do.
+    if (auto* tracer = Tracer::Get()) {
+      tracer->Flush();
+    }
+    if (auto* recorder = Recorder::Get()) {
+      recorder->Flush();
+    }
+    PROBE(wait__begin);
+    WaitForFds(PollTimeout(*connection_));
+    PROBE(wait__end);
+    if (quit_) {
+      return Event(nullptr);
+    }
   }
+}
 
-  for (auto* observer : Observable<EventLoopIdleObserver>::observers()) {
-    observer->OnIdle();
+auto EventLoop::IdleBoundReached() -> bool {
+  if (events_since_idle_ == 0) {
+    return false;
   }
+  if (events_since_idle_ >= max_events_between_idle_) {
+    dispatch_stats_.RecordForcedIdle(DispatchStats::IdleBound::kEvents);
+    return true;
+  }
+  if (std::chrono::steady_clock::now() - busy_since_ >=
+      max_time_between_idle_) {
+    dispatch_stats_.RecordForcedIdle(DispatchStats::IdleBound::kTime);
+    return true;
+  }
+  return false;
+}
 
-  xcb_flush(connection);
+void EventLoop::RunIdlePass() {
+  {
+    TRACE_SPAN("idle", "OnIdle");
+    for (auto* observer : Observable<EventLoopIdleObserver>::observers()) {
+      observer->OnIdle();
+    }
+  }
 
-  while (true) {
-    std::array<struct pollfd, 2> poll_fds{
-        {{should_quit_fd_, POLLIN, 0},
-         {xcb_get_file_descriptor(connection), POLLIN, 0}}};
-    int ready = REDO_ON_EINTR(poll(poll_fds.data(), poll_fds.size(), -1));
-    if (ready == -1) {
-      throw PError("poll");
-    }
-    if (poll_fds[0].revents != 0) {
-      return Event(nullptr);
+  {
+    TRACE_SPAN("idle", "CommitEventMasks");
+    connection_->CommitEventMasks();
+  }
+  {
+    TRACE_SPAN("idle", "xcb_flush");
+    xcb_flush(connection_->connection());
+  }
+  events_since_idle_ = 0;
+}
+
+void EventLoop::WaitForFds(int timeout_ms) {
+  TRACE_SPAN("loop", "WaitForFds");
+  int num_ready = REDO_ON_EINTR(epoll_wait(epoll_fd_, ready_fds_.data(),
+                                           static_cast<int>(kMaxReadyFds),
+                                           timeout_ms));
+  if (num_ready == -1) {
+    throw PError("epoll_wait");
+  }
+  num_ready_fds_ = static_cast<std::size_t>(num_ready);
+  for (std::size_t i = 0; i < num_ready_fds_; i++) {
+    auto* watcher = static_cast<FdWatcher*>(ready_fds_[i].data.ptr);
+    if (watcher == nullptr) {
+      continue;
     }
-    event = xcb_poll_for_event(connection);
-    if ((event != nullptr) || (xcb_connection_has_error(connection) != 0)) {
-      return Event(event);
+    try {
+      watcher->OnFdReadable();
+    } catch (...) {
+      Lippincott();
+    }
+  }
+  num_ready_fds_ = 0;
+}
+
+template <typename Process>
+auto EventLoop::ProcessReplies(Process process) -> bool {
+  ScopedAllocationPhase event_phase(AllocationPhase::kEvent);
+  // A reply callback that throws must not prevent the replies after it
+  // from being handled.
+  bool processed = false;
+  while (true) {
+    try {
+      return process() || processed;
+    } catch (...) {
+      Lippincott();
+      processed = true;
     }
   }
 }
@@ -17,27 +17,127 @@
 
 #pragma once
 
+#include <sys/epoll.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "dispatch_stats.h"
+#include "event_batch.h"
+#include "event_router.h"
+#include "fd_watcher.h"
 #include "observable.h"
+#include "timer_queue.h"
 #include "util.h"
 
+class CommandLine;
 class Connection;
-class Event;
-class EventDispatcher;
 class EventLoopIdleObserver;
 
-class EventLoop : public Observable<EventDispatcher>,
-                  public Observable<EventLoopIdleObserver> {
+class EventLoop : public Observable<EventLoopIdleObserver> {
  public:
-  EventLoop(Connection* connection, int should_quit_fd);
+  EventLoop(Connection* connection, CommandLine* command_line);
   ~EventLoop() override;
 
-  void Run() const;
+  // Dispatches events until Quit() is called or the connection closes.
+  // May be called again once it returns.
+  void Run();
+
+  // Makes Run() return once the current iteration finishes.
+  void Quit() { quit_ = true; }
+
+  // How readiness of a watched fd is reported.
+  enum class Trigger {
+    // |watcher| is called once each time |fd| becomes readable, and must
+    // read until it would block.
+    kEdge,
+    // |watcher| is called after every wait for as long as |fd| is
+    // readable.
+    kLevel,
+  };
+
+  // Calls |watcher| whenever |fd| becomes readable.  |fd| must not already
+  // be watched.
+  void WatchFd(int fd, FdWatcher* watcher, Trigger trigger = Trigger::kEdge);
+  void UnwatchFd(int fd);
+
+  [[nodiscard]] auto event_router() -> EventRouter* {
+    return &event_router_;
+  }
+  [[nodiscard]] auto dispatch_stats() const -> const DispatchStats& {
+    return dispatch_stats_;
+  }
+  [[nodiscard]] auto timer_queue() -> TimerQueue* { return &timer_queue_; }
 
  private:
-  [[nodiscard]] auto WaitForEvent() const -> Event;
+  // WaitForEvent() reads from the connection before every wait, so its
+  // watcher only needs to wake the loop.  xcb_poll_for_event() reads the
+  // socket at most once, which can leave data behind, so the connection
+  // is watched level-triggered.
+  class ConnectionWatcher : public FdWatcher {
+   public:
+    ConnectionWatcher() = default;
+    ~ConnectionWatcher() override = default;
+
+    void OnFdReadable() override {}
+
+   private:
+    DELETE_SPECIAL_MEMBERS(ConnectionWatcher);
+  };
+
+  static constexpr std::size_t kMaxReadyFds = 16;
+
+  [[nodiscard]] auto WaitForEvent() -> Event;
+
+  // Returns true iff enough events were dispatched, or enough time was
+  // spent dispatching them, since the last idle pass that one must be
+  // forced before the next event.
+  auto IdleBoundReached() -> bool;
+
+  // Runs the idle observers, then sends everything they and the event
+  // handlers queued.
+  void RunIdlePass();
+
+  // Blocks until a watched file descriptor is ready or |timeout_ms|
+  // passes, then runs the watchers of the ready descriptors.
+  void WaitForFds(int timeout_ms);
+
+  // Runs |process| until it returns without throwing.  Returns true iff
+  // any reply was handled.
+  template <typename Process>
+  static auto ProcessReplies(Process process) -> bool;
 
   Connection* connection_;
-  int should_quit_fd_;
+  // Kept because XCB stops reporting it once the connection fails.
+  int connection_fd_;
+  int epoll_fd_;
+
+  // Bounds on the work done between idle passes while events keep
+  // arriving, so that a flood cannot starve idle observers.
+  uint32_t max_events_between_idle_;
+  std::chrono::microseconds max_time_between_idle_;
+  uint32_t events_since_idle_ = 0;
+  std::chrono::steady_clock::time_point busy_since_;
+
+  EventRouter event_router_;
+  DispatchStats dispatch_stats_;
+  EventBatch batch_;
+  bool quit_ = false;
+
+  // Descriptors reported ready by the last epoll_wait() whose watchers
+  // have not run yet.  UnwatchFd() clears entries so that a watcher
+  // removed by an earlier watcher is not called.
+  std::array<struct epoll_event, kMaxReadyFds> ready_fds_{};
+  std::size_t num_ready_fds_ = 0;
+
+  std::vector<std::pair<int, FdWatcher*>> watchers_;
+
+  ConnectionWatcher connection_watcher_;
+  TimerQueue timer_queue_;
 
   DELETE_SPECIAL_MEMBERS(EventLoop);
 };
@@ -0,0 +1,151 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "event_mask_table.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr unsigned int kInitialCapacityLog2 = 6;
+
+// Fibonacci hashing spreads the mostly-sequential X resource IDs across
+// the table.
+constexpr uint32_t kHashMultiplier = 0x9e3779b9U;
+constexpr unsigned int kHashBits = 32;
+
+}  // namespace
+
+void MultiMask::AddMask(uint32_t mask) {
+  // A count is saturated when its bit is set in every plane.  Check before
+  // touching any plane so that the counts are unchanged on overflow.
+  uint32_t saturated = ~0U;
+  for (auto plane : planes_) {
+    saturated &= plane;
+  }
+  if ((saturated & mask) != 0) {
+    throw std::overflow_error("Event mask selected too many times");
+  }
+
+  uint32_t carry = mask;
+  for (auto& plane : planes_) {
+    const uint32_t next_carry = plane & carry;
+    plane ^= carry;
+    carry = next_carry;
+  }
+}
+
+void MultiMask::RemoveMask(uint32_t mask) {
+  DCHECK((ToMask() & mask) == mask);
+  uint32_t borrow = mask;
+  for (auto& plane : planes_) {
+    const uint32_t next_borrow = ~plane & borrow;
+    plane ^= borrow;
+    borrow = next_borrow;
+  }
+}
+
+auto MultiMask::ToMask() const -> uint32_t {
+  uint32_t mask = 0;
+  for (auto plane : planes_) {
+    mask |= plane;
+  }
+  return mask;
+}
+
+EventMaskTable::EventMaskTable()
+    : entries_(std::size_t{1} << kInitialCapacityLog2, Entry{}),
+      shift_(kHashBits - kInitialCapacityLog2) {}
+
+EventMaskTable::~EventMaskTable() = default;
+
+auto EventMaskTable::Find(xcb_window_t window) -> WindowEventMask* {
+  const std::size_t mask = entries_.size() - 1;
+  for (std::size_t i = IndexOf(window);; i = (i + 1) & mask) {
+    if (entries_[i].window == window) {
+      return &entries_[i].mask;
+    }
+    if (entries_[i].window == kEmpty) {
+      return nullptr;
+    }
+  }
+}
+
+auto EventMaskTable::FindOrInsert(xcb_window_t window) -> WindowEventMask* {
+  DCHECK(window != kEmpty);
+  if (auto* mask = Find(window)) {
+    return mask;
+  }
+  // Keep the load factor at most 1/2 so that probe sequences stay short.
+  if (2 * (size_ + 1) > entries_.size()) {
+    Grow();
+  }
+  const std::size_t mask = entries_.size() - 1;
+  std::size_t i = IndexOf(window);
+  while (entries_[i].window != kEmpty) {
+    i = (i + 1) & mask;
+  }
+  entries_[i] = Entry{window, WindowEventMask{}};
+  size_++;
+  return &entries_[i].mask;
+}
+
+void EventMaskTable::Erase(xcb_window_t window) {
+  const std::size_t mask = entries_.size() - 1;
+  std::size_t i = IndexOf(window);
+  while (entries_[i].window != window) {
+    DCHECK(entries_[i].window != kEmpty);
+    i = (i + 1) & mask;
+  }
+
+  // Backward-shift deletion: move later entries of the probe sequence
+  // into the hole so that lookups never need tombstones.
+  std::size_t hole = i;
+  for (std::size_t j = (hole + 1) & mask; entries_[j].window != kEmpty;
+       j = (j + 1) & mask) {
+    const std::size_t home = IndexOf(entries_[j].window);
+    // Move the entry unless its home slot lies cyclically in (hole, j].
+    if (((j - home) & mask) >= ((j - hole) & mask)) {
+      entries_[hole] = entries_[j];
+      hole = j;
+    }
+  }
+  entries_[hole] = Entry{};
+  size_--;
+}
+
+auto EventMaskTable::IndexOf(xcb_window_t window) const -> std::size_t {
+  return (window * kHashMultiplier) >> shift_;
+}
+
+void EventMaskTable::Grow() {
+  std::vector<Entry> old_entries(2 * entries_.size(), Entry{});
+  std::swap(entries_, old_entries);
+  shift_--;
+  const std::size_t mask = entries_.size() - 1;
+  for (const auto& entry : old_entries) {
+    if (entry.window == kEmpty) {
+      continue;
+    }
+    std::size_t i = IndexOf(entry.window);
+    while (entries_[i].window != kEmpty) {
+      i = (i + 1) & mask;
+    }
+    entries_[i] = entry;
+  }
+}
@@ -0,0 +1,107 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "util.h"
+
+using xcb_window_t = uint32_t;
+
+// Reference counts for each bit of an X event mask.  The counts are
+// stored bit-sliced: bit i of |planes_[k]| is bit k of the count for
+// event mask bit i.  Adding or removing a whole event mask is then a
+// ripple-carry over a few words instead of a loop over every event bit.
+class MultiMask {
+ public:
+  // Throws std::overflow_error if any count would exceed kMaxCount.
+  void AddMask(uint32_t mask);
+  void RemoveMask(uint32_t mask);
+
+  [[nodiscard]] auto ToMask() const -> uint32_t;
+
+  static constexpr unsigned int kMaxCount = 255;
+
+ private:
+  static constexpr std::size_t kCountBits = 8;
+
+  std::array<uint32_t, kCountBits> planes_{};
+};
+
+struct WindowEventMask {
+  // Reference counts of the events selected by clients of Connection.
+  MultiMask requested;
+
+  // The event mask last sent to the server.
+  uint32_t committed = 0;
+
+  // True iff the window is queued to have |requested| committed.
+  bool dirty = false;
+};
+
+// Open-addressed map from windows to their WindowEventMask.  Entries are
+// stored inline, so lookups, insertions and removals do not allocate
+// except when the table grows.
+class EventMaskTable {
+ public:
+  EventMaskTable();
+  ~EventMaskTable();
+
+  // Returns null if |window| has no entry.
+  [[nodiscard]] auto Find(xcb_window_t window) -> WindowEventMask*;
+
+  // Returns the entry for |window|, inserting an empty one if necessary.
+  // Invalidates pointers to other entries if the table grows.
+  auto FindOrInsert(xcb_window_t window) -> WindowEventMask*;
+
+  // Removes the entry for |window|, which must exist.  Invalidates
+  // pointers to other entries.
+  void Erase(xcb_window_t window);
+
+  template <typename Visitor>
+  void ForEach(Visitor visitor) const {
+    for (const auto& entry : entries_) {
+      if (entry.window != kEmpty) {
+        visitor(entry.window, entry.mask);
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    xcb_window_t window;
+    WindowEventMask mask;
+  };
+
+  // XCB_WINDOW_NONE is never selected on, so it marks empty slots.
+  static constexpr xcb_window_t kEmpty = 0;
+
+  [[nodiscard]] auto IndexOf(xcb_window_t window) const -> std::size_t;
+  void Grow();
+
+  std::vector<Entry> entries_;
+  std::size_t size_ = 0;
+
+  // Number of bits to drop from the 32-bit hash to index |entries_|.
+  unsigned int shift_;
+
+  DELETE_SPECIAL_MEMBERS(EventMaskTable);
+};
@@ -0,0 +1,46 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Events of a batch are dispatched in this order, and in arrival order
+// within each class.
+enum class EventPriority : uint8_t {
+  // Input that can change what is shown, such as key presses.
+  kInput,
+  // Changes to what the indicator tracks, such as the active window.
+  kState,
+  // Everything else, such as geometry updates.
+  kBulk,
+};
+
+constexpr std::size_t kNumEventPriorities = 3;
+
+constexpr auto EventPriorityName(EventPriority priority) -> const char* {
+  switch (priority) {
+    case EventPriority::kInput:
+      return "input";
+    case EventPriority::kState:
+      return "state";
+    case EventPriority::kBulk:
+      return "bulk";
+  }
+  return "unknown";
+}
@@ -0,0 +1,61 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "event_ring.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "recorder.h"
+
+namespace {
+
+// XCB stores |full_sequence| after the 32 bytes of wire data and moves
+// the rest of a generic event after it.
+auto EventSize(const xcb_generic_event_t& event) -> std::size_t {
+  std::size_t size = sizeof(xcb_generic_event_t);
+  if ((event.response_type & ~0x80U) == XCB_GE_GENERIC) {
+    const auto& generic_event =
+        reinterpret_cast<const xcb_ge_generic_event_t&>(event);
+    size += std::size_t{generic_event.length} * 4;
+  }
+  return size;
+}
+
+}  // namespace
+
+EventRing::EventRing() : slots_(std::make_unique<std::array<Slot, kSlots>>()) {}
+
+EventRing::~EventRing() = default;
+
+auto EventRing::Store(xcb_generic_event_t* event) -> Event {
+  if (auto* recorder = Recorder::Get()) {
+    recorder->RecordEvent(*event);
+  }
+
+  auto size = EventSize(*event);
+  if (size > kSlotSize) {
+    return Event(event);
+  }
+
+  auto& slot = (*slots_)[next_];
+  next_ = (next_ + 1) % kSlots;
+  std::memcpy(slot.bytes.data(), event, size);
+  std::free(event);
+  return Event::Borrow(
+      reinterpret_cast<const xcb_generic_event_t*>(slot.bytes.data()));
+}
@@ -0,0 +1,58 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "event.h"
+#include "util.h"
+
+// Preallocated storage for events read from XCB.  Each event is copied
+// into the next slot and XCB's buffer is freed at once, so holding
+// events costs no allocations.  Slots are reused in order, which keeps an
+// Event valid until kSlots more have been stored.
+class EventRing {
+ public:
+  static constexpr std::size_t kSlots = 64;
+
+  // Large enough for core events and the XInput2 device events, which
+  // are the largest generic events this program selects.
+  static constexpr std::size_t kSlotSize = 256;
+
+  EventRing();
+  ~EventRing();
+
+  // Takes ownership of |event|.  Events that do not fit in a slot are
+  // kept in XCB's buffer instead.
+  [[nodiscard]] auto Store(xcb_generic_event_t* event) -> Event;
+
+ private:
+  struct alignas(alignof(std::max_align_t)) Slot {
+    std::array<uint8_t, kSlotSize> bytes;
+  };
+
+  std::unique_ptr<std::array<Slot, kSlots>> slots_;
+  std::size_t next_ = 0;
+
+  DELETE_SPECIAL_MEMBERS(EventRing);
+};
@@ -0,0 +1,82 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "event_route.h"
+
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+
+#include "event.h"
+
+namespace {
+
+constexpr unsigned int kResponseTypeShift = 48;
+constexpr unsigned int kEventTypeShift = 32;
+
+template <typename StructureEvent>
+auto EventWindow(const Event& event) -> xcb_window_t {
+  return reinterpret_cast<const StructureEvent*>(event.event())->event;
+}
+
+}  // namespace
+
+// static
+auto EventRoute::ForWindow(uint8_t response_type, xcb_window_t window)
+    -> EventRoute {
+  return EventRoute(uint64_t{response_type} << kResponseTypeShift | window);
+}
+
+// static
+auto EventRoute::ForGenericEvent(uint8_t extension, uint16_t event_type)
+    -> EventRoute {
+  return EventRoute(uint64_t{XCB_GE_GENERIC} << kResponseTypeShift |
+                    uint64_t{event_type} << kEventTypeShift | extension);
+}
+
+// static
+auto EventRoute::FromEvent(const Event& event) -> std::optional<EventRoute> {
+  auto type = event.ResponseType();
+  switch (type) {
+    case XCB_CIRCULATE_NOTIFY:
+      return ForWindow(type, EventWindow<xcb_circulate_notify_event_t>(event));
+    case XCB_CONFIGURE_NOTIFY:
+      return ForWindow(type, EventWindow<xcb_configure_notify_event_t>(event));
+    case XCB_DESTROY_NOTIFY:
+      return ForWindow(type, EventWindow<xcb_destroy_notify_event_t>(event));
+    case XCB_GRAVITY_NOTIFY:
+      return ForWindow(type, EventWindow<xcb_gravity_notify_event_t>(event));
+    case XCB_MAP_NOTIFY:
+      return ForWindow(type, EventWindow<xcb_map_notify_event_t>(event));
+    case XCB_REPARENT_NOTIFY:
+      return ForWindow(type, EventWindow<xcb_reparent_notify_event_t>(event));
+    case XCB_UNMAP_NOTIFY:
+      return ForWindow(type, EventWindow<xcb_unmap_notify_event_t>(event));
+    case XCB_PROPERTY_NOTIFY:
+      return ForWindow(
+          type, reinterpret_cast<const xcb_property_notify_event_t*>(
+                    event.event())
+                    ->window);
+    case XCB_GE_GENERIC: {
+      const auto* generic_event =
+          reinterpret_cast<const xcb_ge_generic_event_t*>(event.event());
+      return ForGenericEvent(generic_event->extension,
+                             generic_event->event_type);
+    }
+    default:
+      return std::nullopt;
+  }
+}
@@ -0,0 +1,59 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+using xcb_window_t = uint32_t;
+
+class Event;
+
+// Identifies the events an EventHandler receives: either a core event
+// type delivered to a window, or an event type of an extension that uses
+// generic events.
+class EventRoute {
+ public:
+  struct Hash {
+    auto operator()(const EventRoute& route) const -> std::size_t {
+      return static_cast<std::size_t>(route.key_ * 0x9e3779b97f4a7c15ULL);
+    }
+  };
+
+  // |window| is the window the event was selected on.
+  static auto ForWindow(uint8_t response_type, xcb_window_t window)
+      -> EventRoute;
+
+  static auto ForGenericEvent(uint8_t extension, uint16_t event_type)
+      -> EventRoute;
+
+  // Returns nullopt for events that are never routed.
+  static auto FromEvent(const Event& event) -> std::optional<EventRoute>;
+
+  auto operator==(const EventRoute& other) const -> bool {
+    return key_ == other.key_;
+  }
+
+ private:
+  explicit EventRoute(uint64_t key) : key_(key) {}
+
+  // Packed as response_type << 48 | event_type << 32 | window, where a
+  // generic event stores its extension opcode in place of the window.
+  uint64_t key_;
+};
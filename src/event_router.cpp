@@ -0,0 +1,133 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "event_router.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "event.h"
+#include "lippincott.h"
+#include "probes.h"
+#include "tracer.h"
+
+EventRouter::EventRouter() = default;
+
+EventRouter::~EventRouter() {
+  DCHECK(routes_.empty());
+}
+
+void EventRouter::AddHandler(const EventHandler& handler) {
+  routes_[handler.route()].push_back({handler, false});
+}
+
+void EventRouter::RemoveHandler(const EventHandler& handler) {
+  auto it = routes_.find(handler.route());
+  DCHECK(it != routes_.end());
+  auto& entries = it->second;
+  auto entry = std::find_if(entries.begin(), entries.end(),
+                            [&handler](const Entry& candidate) {
+                              return !candidate.removed &&
+                                     candidate.handler == handler;
+                            });
+  DCHECK(entry != entries.end());
+  if (dispatching_) {
+    entry->removed = true;
+    swept_routes_.push_back(handler.route());
+    return;
+  }
+  entries.erase(entry);
+  if (entries.empty()) {
+    routes_.erase(it);
+  }
+}
+
+auto EventRouter::PriorityOf(const Event& event) const -> EventPriority {
+  auto priority = EventPriority::kBulk;
+  auto route = EventRoute::FromEvent(event);
+  if (!route) {
+    return priority;
+  }
+  auto it = routes_.find(*route);
+  if (it == routes_.end()) {
+    return priority;
+  }
+  for (const auto& entry : it->second) {
+    if (!entry.removed) {
+      priority = std::min(priority, entry.handler.priority());
+    }
+  }
+  return priority;
+}
+
+auto EventRouter::Dispatch(const Event& event) -> bool {
+  auto route = EventRoute::FromEvent(event);
+  if (!route) {
+    return false;
+  }
+  auto it = routes_.find(*route);
+  if (it == routes_.end()) {
+    return false;
+  }
+  PROBE2(dispatch__begin, event.ResponseType(), event.Sequence());
+
+  // Handlers may add or remove handlers.  Added ones wait for the next
+  // event and removed ones are only marked, so index the vector afresh
+  // each time in case it grew.
+  auto& entries = it->second;
+  ScopedTraceSpan span("dispatch", "Dispatch");
+  span.SetEvent(event);
+  dispatching_ = true;
+  for (std::size_t i = 0, size = entries.size(); i < size; i++) {
+    if (entries[i].removed) {
+      continue;
+    }
+    // Each handler's span is named after the event type and annotated
+    // with the event's window, so that handlers can be told apart.
+    ScopedTraceSpan handler_span("dispatch", entries[i].handler.name());
+    handler_span.SetEvent(event);
+    try {
+      entries[i].handler.Run(*event.event());
+    } catch (...) {
+      Lippincott();
+    }
+  }
+  dispatching_ = false;
+  PROBE2(dispatch__end, event.ResponseType(), event.Sequence());
+
+  SweepRemoved();
+  return true;
+}
+
+void EventRouter::SweepRemoved() {
+  for (const auto& route : swept_routes_) {
+    auto it = routes_.find(route);
+    if (it == routes_.end()) {
+      continue;
+    }
+    auto& entries = it->second;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const Entry& entry) {
+                                   return entry.removed;
+                                 }),
+                  entries.end());
+    if (entries.empty()) {
+      routes_.erase(it);
+    }
+  }
+  swept_routes_.clear();
+}
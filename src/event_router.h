@@ -0,0 +1,66 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "event_handler.h"
+#include "event_priority.h"
+#include "event_route.h"
+#include "util.h"
+
+class Event;
+
+// Sends each event straight to the handlers registered for its
+// EventRoute, so dispatch cost does not grow with the number of
+// handlers.
+class EventRouter {
+ public:
+  EventRouter();
+  ~EventRouter();
+
+  void AddHandler(const EventHandler& handler);
+  void RemoveHandler(const EventHandler& handler);
+
+  // Returns the highest priority of the handlers on the route of |event|,
+  // or kBulk if it has none.
+  [[nodiscard]] auto PriorityOf(const Event& event) const -> EventPriority;
+
+  // Runs every handler on the route of |event| in the order they were
+  // added.  Returns false iff there were none.
+  auto Dispatch(const Event& event) -> bool;
+
+ private:
+  struct Entry {
+    EventHandler handler;
+
+    // Set instead of erasing the entry while its route is dispatched.
+    bool removed;
+  };
+
+  // Erases the entries that were removed during Dispatch().
+  void SweepRemoved();
+
+  std::unordered_map<EventRoute, std::vector<Entry>, EventRoute::Hash> routes_;
+
+  bool dispatching_ = false;
+  std::vector<EventRoute> swept_routes_;
+
+  DELETE_SPECIAL_MEMBERS(EventRouter);
+};
@@ -0,0 +1,81 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/present.h>
+#include <xcb/xcb.h>
+#include <xcb/xinput.h>
+#include <xcb/xproto.h>
+
+#include <cstdint>
+
+// Maps each event struct to its name, for traces, and each core event
+// struct to the response type it is decoded from.
+template <typename XEvent>
+struct EventTraits;
+
+#define DEFINE_EVENT_TRAITS(XEvent, response_type, name)    \
+  template <>                                               \
+  struct EventTraits<XEvent> {                              \
+    static constexpr uint8_t kResponseType = response_type; \
+    static constexpr const char* kName = name;              \
+  }
+
+#define DEFINE_GENERIC_EVENT_TRAITS(XEvent, name) \
+  template <>                                     \
+  struct EventTraits<XEvent> {                    \
+    static constexpr const char* kName = name;    \
+  }
+
+DEFINE_EVENT_TRAITS(xcb_circulate_notify_event_t,
+                    XCB_CIRCULATE_NOTIFY,
+                    "CirculateNotify");
+DEFINE_EVENT_TRAITS(xcb_configure_notify_event_t,
+                    XCB_CONFIGURE_NOTIFY,
+                    "ConfigureNotify");
+DEFINE_EVENT_TRAITS(xcb_destroy_notify_event_t,
+                    XCB_DESTROY_NOTIFY,
+                    "DestroyNotify");
+DEFINE_EVENT_TRAITS(xcb_gravity_notify_event_t,
+                    XCB_GRAVITY_NOTIFY,
+                    "GravityNotify");
+DEFINE_EVENT_TRAITS(xcb_map_notify_event_t, XCB_MAP_NOTIFY, "MapNotify");
+DEFINE_EVENT_TRAITS(xcb_property_notify_event_t,
+                    XCB_PROPERTY_NOTIFY,
+                    "PropertyNotify");
+DEFINE_EVENT_TRAITS(xcb_reparent_notify_event_t,
+                    XCB_REPARENT_NOTIFY,
+                    "ReparentNotify");
+DEFINE_EVENT_TRAITS(xcb_unmap_notify_event_t, XCB_UNMAP_NOTIFY, "UnmapNotify");
+
+// XI2 key presses and releases share a struct.
+DEFINE_GENERIC_EVENT_TRAITS(xcb_input_key_press_event_t, "XIKeyEvent");
+DEFINE_GENERIC_EVENT_TRAITS(xcb_present_complete_notify_event_t,
+                            "PresentCompleteNotify");
+
+#undef DEFINE_GENERIC_EVENT_TRAITS
+#undef DEFINE_EVENT_TRAITS
+
+// Deduces the event struct handled by a member function.
+template <typename Method>
+struct EventHandlerMethodTraits;
+
+template <typename Target, typename XEvent>
+struct EventHandlerMethodTraits<void (Target::*)(const XEvent&)> {
+  using Event = XEvent;
+};
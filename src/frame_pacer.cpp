@@ -0,0 +1,181 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "frame_pacer.h"
+
+#include <xcb/randr.h>
+#include <xcb/xcb.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "connection.h"
+#include "event_handler.h"
+#include "timeout_error.h"
+
+namespace {
+
+constexpr const std::chrono::milliseconds kPresentTimeout{100};
+constexpr const double kDefaultRefreshRate = 60.0;
+
+// The refresh rate only tunes pacing, so a server that is slow to report
+// it should not hold up startup for the full request timeout.
+constexpr const std::chrono::milliseconds kRandrTimeout{500};
+
+auto ModeRefreshRate(const xcb_randr_mode_info_t& mode) -> double {
+  double vtotal = mode.vtotal;
+  if ((mode.mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN) != 0U) {
+    vtotal *= 2;
+  }
+  if ((mode.mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE) != 0U) {
+    vtotal /= 2;
+  }
+  if (mode.htotal == 0 || vtotal == 0) {
+    return 0;
+  }
+  return mode.dot_clock / (mode.htotal * vtotal);
+}
+
+// Returns the refresh rate of the fastest active CRTC, or 0 if RandR
+// cannot tell.
+auto QueryRandrRefreshRate(Connection* connection) -> double {
+  auto* c = connection->connection();
+  double rate = 0;
+
+  // GetScreenResourcesCurrent needs RandR 1.3.
+  auto version = XCB_SYNC_TIMEOUT(kRandrTimeout, xcb_randr_query_version,
+                                  connection, 1, 3);
+  if (version->major_version > 1 ||
+      (version->major_version == 1 && version->minor_version >= 3)) {
+    auto resources = XCB_SYNC_TIMEOUT(
+        kRandrTimeout, xcb_randr_get_screen_resources_current, connection,
+        connection->root_window());
+    const auto* crtcs =
+        xcb_randr_get_screen_resources_current_crtcs(resources.get());
+    const auto* modes =
+        xcb_randr_get_screen_resources_current_modes(resources.get());
+    const auto* modes_end =
+        modes + xcb_randr_get_screen_resources_current_modes_length(
+                    resources.get());
+
+    std::vector<xcb_randr_get_crtc_info_cookie_t> cookies;
+    for (int i = 0; i < resources->num_crtcs; i++) {
+      cookies.push_back(xcb_randr_get_crtc_info(
+          c, crtcs[i], resources->config_timestamp));
+    }
+    for (auto cookie : cookies) {
+      auto crtc = XCB_REPLY(xcb_randr_get_crtc_info, connection, cookie);
+      const auto* mode = std::find_if(
+          modes, modes_end, [&crtc](const xcb_randr_mode_info_t& info) {
+            return info.id == crtc->mode;
+          });
+      if (crtc->mode != XCB_NONE && mode != modes_end) {
+        rate = std::max(rate, ModeRefreshRate(*mode));
+      }
+    }
+  }
+  return rate;
+}
+
+}  // namespace
+
+FramePacer::FramePacer(Connection* connection,
+                       EventLoop* event_loop,
+                       std::function<void()> on_frame)
+    : connection_(connection),
+      on_frame_(std::move(on_frame)),
+      last_frame_(Clock::now()),
+      timer_(event_loop, [this]() { OnFrame(); }) {
+  const auto* present = connection_->ExtensionData(&xcb_present_id);
+  if (present == nullptr || present->present == 0U) {
+    refresh_interval_ = QueryRefreshInterval();
+    return;
+  }
+  XCB_SYNC(xcb_present_query_version, connection_, XCB_PRESENT_MAJOR_VERSION,
+           XCB_PRESENT_MINOR_VERSION);
+
+  present_event_ = connection_->GenerateId();
+  XCB_VOID(xcb_present_select_input, connection_, present_event_,
+           connection_->root_window(), XCB_PRESENT_EVENT_MASK_COMPLETE_NOTIFY);
+  event_handlers_ = std::make_unique<ScopedEventHandlers>(
+      event_loop,
+      std::initializer_list<EventHandler>{
+          EventHandler::ForGenericEvent<&FramePacer::OnCompleteNotify>(
+              this, present->major_opcode, XCB_PRESENT_COMPLETE_NOTIFY)});
+}
+
+FramePacer::~FramePacer() {
+  if (present_event_ != 0) {
+    XCB_VOID(xcb_present_select_input, connection_, present_event_,
+             connection_->root_window(), XCB_PRESENT_EVENT_MASK_NO_EVENT);
+  }
+}
+
+void FramePacer::RequestFrame() {
+  if (frame_pending_) {
+    return;
+  }
+  frame_pending_ = true;
+
+  if (present_event_ != 0) {
+    // A target MSC of 0 with a divisor of 1 means the next vblank.
+    XCB_VOID(xcb_present_notify_msc, connection_, connection_->root_window(),
+             ++present_serial_, 0, 1, 0);
+    timer_.Start(kPresentTimeout);
+    return;
+  }
+
+  // Stay in phase with the previous frame.
+  auto since_last_frame = Clock::now() - last_frame_;
+  timer_.Start(refresh_interval_ - since_last_frame % refresh_interval_);
+}
+
+auto FramePacer::QueryRefreshInterval() -> Clock::duration {
+  double rate = 0;
+
+  const auto* randr = connection_->ExtensionData(&xcb_randr_id);
+  if (randr != nullptr && randr->present != 0U) {
+    try {
+      rate = QueryRandrRefreshRate(connection_);
+    } catch (const TimeoutError&) {
+      // Pace at the default rate rather than fail.
+    }
+  }
+
+  if (rate <= 0) {
+    rate = kDefaultRefreshRate;
+  }
+  return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1 / rate));
+}
+
+void FramePacer::OnCompleteNotify(
+    const xcb_present_complete_notify_event_t& event) {
+  if (event.kind == XCB_PRESENT_COMPLETE_KIND_NOTIFY_MSC &&
+      event.serial == present_serial_ && frame_pending_) {
+    OnFrame();
+  }
+}
+
+void FramePacer::OnFrame() {
+  frame_pending_ = false;
+  last_frame_ = Clock::now();
+  timer_.Stop();
+  on_frame_();
+}
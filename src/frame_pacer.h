@@ -0,0 +1,81 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/present.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "scoped_event_handlers.h"
+#include "timer.h"
+#include "util.h"
+
+class Connection;
+class EventLoop;
+
+// Limits updates to one per display refresh.  The next frame is signalled
+// by a Present MSC notification on the root window when the extension is
+// available, and otherwise by a timer at the refresh rate that RandR
+// reports.
+class FramePacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // |on_frame| is run at each requested frame.
+  FramePacer(Connection* connection,
+             EventLoop* event_loop,
+             std::function<void()> on_frame);
+  ~FramePacer();
+
+  // Asks to be woken at the next frame, unless that was already asked
+  // for.  frame_pending() is true until then.
+  void RequestFrame();
+
+  [[nodiscard]] auto frame_pending() const -> bool { return frame_pending_; }
+
+ private:
+  // Returns the refresh interval of the fastest active CRTC.
+  auto QueryRefreshInterval() -> Clock::duration;
+
+  void OnCompleteNotify(const xcb_present_complete_notify_event_t& event);
+  void OnFrame();
+
+  Connection* connection_;
+  std::function<void()> on_frame_;
+
+  // The refresh interval used when Present is not available.  Only
+  // queried in that case, since RandR costs several round trips.
+  Clock::duration refresh_interval_{};
+  Clock::time_point last_frame_;
+  bool frame_pending_ = false;
+
+  // The Present event context, or 0 if Present is not available.
+  uint32_t present_event_ = 0;
+  uint32_t present_serial_ = 0;
+  std::unique_ptr<ScopedEventHandlers> event_handlers_;
+
+  // Drives frames without Present.  With Present, bounds the wait for a
+  // notification that may never come, for example while the display is
+  // off.
+  Timer timer_;
+
+  DELETE_SPECIAL_MEMBERS(FramePacer);
+};
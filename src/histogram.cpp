@@ -0,0 +1,54 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+void Histogram::Record(std::chrono::nanoseconds duration) {
+  const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::max(duration, std::chrono::nanoseconds{0}))
+                      .count();
+  const auto i = std::min<std::size_t>(
+      std::bit_width(static_cast<uint64_t>(us)), kBuckets - 1);
+  buckets_[i]++;
+  count_++;
+  sum_ += duration;
+}
+
+// static
+auto Histogram::BucketLimit(std::size_t i) -> uint64_t {
+  return uint64_t{1} << i;
+}
+
+auto Histogram::Quantile(double q) const -> uint64_t {
+  if (count_ == 0) {
+    return 0;
+  }
+  const auto rank = static_cast<uint64_t>(
+      std::ceil(q * static_cast<double>(count_)));
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; i++) {
+    seen += buckets_[i];
+    if (seen >= std::max<uint64_t>(rank, 1)) {
+      return BucketLimit(i);
+    }
+  }
+  return BucketLimit(kBuckets - 1);
+}
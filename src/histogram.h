@@ -0,0 +1,51 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Histogram of durations with power-of-two microsecond buckets.  Bucket 0
+// counts durations under 1 us, and bucket i counts durations in
+// [2^(i-1), 2^i) us.  The last bucket also counts anything longer.
+class Histogram {
+ public:
+  static constexpr std::size_t kBuckets = 32;
+
+  void Record(std::chrono::nanoseconds duration);
+
+  [[nodiscard]] auto count() const -> uint64_t { return count_; }
+  [[nodiscard]] auto sum() const -> std::chrono::nanoseconds { return sum_; }
+  [[nodiscard]] auto bucket(std::size_t i) const -> uint64_t {
+    return buckets_[i];
+  }
+
+  // Exclusive upper bound of bucket |i|, in microseconds.
+  static auto BucketLimit(std::size_t i) -> uint64_t;
+
+  // Returns the upper bound of the bucket containing quantile |q|, in
+  // microseconds, or 0 if nothing was recorded.
+  [[nodiscard]] auto Quantile(double q) const -> uint64_t;
+
+ private:
+  std::array<uint64_t, kBuckets> buckets_{};
+  uint64_t count_ = 0;
+  std::chrono::nanoseconds sum_{0};
+};
@@ -0,0 +1,38 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <cstdint>
+
+#include "util.h"
+
+// A server that Connection talks to over a socket pair instead of the X
+// server named by $DISPLAY.
+class InProcessServer {
+ public:
+  // Returns the client end of the socket pair, which the caller must
+  // close.  May only be called once.
+  [[nodiscard]] virtual auto TakeClientFd() -> int = 0;
+
+  // Called when the client starts waiting for the reply to request
+  // |sequence|.
+  virtual void ExpectReply(uint32_t sequence) = 0;
+
+ protected:
+  DEFAULT_VIRTUAL_DESTRUCTOR_AND_SPECIAL_MEMBERS(InProcessServer);
+};
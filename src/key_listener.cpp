@@ -26,38 +26,40 @@
 #include <iterator>
 
 #include "connection.h"
-#include "event.h"
 #include "event_loop.h"
 #include "key_state_observer.h"
-#include "x_error.h"
+#include "startup_info.h"
+#include "tracer.h"
 
 namespace {
 
 void SelectEvents(Connection* connection,
                   xcb_input_xi_event_mask_t event_mask) {
+  // Every key event of a slave keyboard is also sent from its master, so
+  // selecting all devices would deliver each keystroke twice.
   const struct {
     xcb_input_event_mask_t event_mask;
     xcb_input_xi_event_mask_t xi_event_mask;
-  } mask = {{XCB_INPUT_DEVICE_ALL,
+  } mask = {{XCB_INPUT_DEVICE_ALL_MASTER,
              sizeof(xcb_input_xi_event_mask_t) / sizeof(uint32_t)},
             event_mask};
-  xcb_input_xi_select_events(connection->connection(),
-                             connection->root_window(), 1, &mask.event_mask);
+  XCB_VOID(xcb_input_xi_select_events, connection, connection->root_window(),
+           1, &mask.event_mask);
 }
 
 }  // namespace
 
-KeyListener::KeyListener(Connection* connection, EventLoop* event_loop)
-    : connection_(connection), dispatcher_(this, event_loop) {
-  XCB_SYNC(xcb_input_xi_query_version, connection_, XCB_INPUT_MAJOR_VERSION,
-           XCB_INPUT_MINOR_VERSION);
-  auto* input_extension =
-      xcb_get_extension_data(connection_->connection(), &xcb_input_id);
-  if (input_extension->present == 0U) {
-    throw XError("XINPUT not available");
-  }
-  xcb_input_major_opcode_ = input_extension->major_opcode;
-
+KeyListener::KeyListener(Connection* connection,
+                         EventLoop* event_loop,
+                         const StartupInfo& startup_info)
+    : connection_(connection),
+      event_handlers_(event_loop,
+                      {EventHandler::ForGenericEvent<&KeyListener::OnKeyEvent>(
+                           this, startup_info.xinput_major_opcode(),
+                           XCB_INPUT_KEY_PRESS, EventPriority::kInput),
+                       EventHandler::ForGenericEvent<&KeyListener::OnKeyEvent>(
+                           this, startup_info.xinput_major_opcode(),
+                           XCB_INPUT_KEY_RELEASE, EventPriority::kInput)}) {
   SelectEvents(connection_, static_cast<xcb_input_xi_event_mask_t>(
                                 XCB_INPUT_XI_EVENT_MASK_KEY_PRESS |
                                 XCB_INPUT_XI_EVENT_MASK_KEY_RELEASE));
@@ -67,36 +69,16 @@ KeyListener::~KeyListener() {
   SelectEvents(connection_, static_cast<xcb_input_xi_event_mask_t>(0));
 }
 
-auto KeyListener::DispatchEvent(const Event& event) -> bool {
-  if (event.ResponseType() != XCB_GE_GENERIC) {
-    return false;
-  }
-
-  const auto* generic_event =
-      reinterpret_cast<const xcb_ge_generic_event_t*>(event.event());
-  if (generic_event->extension != xcb_input_major_opcode_) {
-    return false;
-  }
-
-  bool press;
-  if (generic_event->event_type == XCB_INPUT_KEY_PRESS) {
-    press = true;
-  } else if (generic_event->event_type == XCB_INPUT_KEY_RELEASE) {
-    press = false;
-  } else {
-    return false;
-  }
-
-  const auto* key_event =
-      reinterpret_cast<const xcb_input_key_press_event_t*>(generic_event);
-  const auto key = key_event->detail;
+void KeyListener::OnKeyEvent(const xcb_input_key_press_event_t& key_event) {
+  const bool press = key_event.event_type == XCB_INPUT_KEY_PRESS;
+  const auto key = key_event.detail;
   auto it =
       std::find_if(std::begin(key_code_states_), std::end(key_code_states_),
                    [key](const KeyCodeState& key_code_state) {
                      return key_code_state.code() == key;
                    });
   if (it == std::end(key_code_states_)) {
-    return true;
+    return;
   }
   it->set_key_pressed(press);
 
@@ -107,9 +89,9 @@ auto KeyListener::DispatchEvent(const Event& event) -> bool {
                   });
   if (any_key_pressed != any_key_pressed_) {
     any_key_pressed_ = any_key_pressed;
+    TRACE_SPAN("observer", "KeyStateChanged");
     for (auto* observer : observers()) {
       observer->KeyStateChanged();
     }
   }
-  return true;
 }
@@ -17,33 +17,31 @@
 
 #pragma once
 
+#include <xcb/xinput.h>
+
 #include <cstdint>
 #include <vector>
 
-#include "event_dispatcher.h"
 #include "observable.h"
-#include "scoped_observer.h"
+#include "scoped_event_handlers.h"
 #include "util.h"
 
 class Connection;
-class Event;
 class EventLoop;
 class KeyStateObserver;
+class StartupInfo;
 
-class KeyListener : public EventDispatcher,
-                    public Observable<KeyStateObserver> {
+class KeyListener : public Observable<KeyStateObserver> {
  public:
-  KeyListener(Connection* connection, EventLoop* event_loop);
+  KeyListener(Connection* connection,
+              EventLoop* event_loop,
+              const StartupInfo& startup_info);
   ~KeyListener() override;
 
   [[nodiscard]] auto any_key_pressed() const -> bool {
     return any_key_pressed_;
   }
 
- protected:
-  // EventDispatcher:
-  auto DispatchEvent(const Event& event) -> bool override;
-
  private:
   // TODO(tomKPZ): Don't hardcode these keycodes.
   constexpr static uint32_t kWinKeyLeft = 133;
@@ -64,14 +62,14 @@ class KeyListener : public EventDispatcher,
     bool key_pressed_ = false;
   };
 
+  void OnKeyEvent(const xcb_input_key_press_event_t& key_event);
+
   std::vector<KeyCodeState> key_code_states_{KeyCodeState{kWinKeyLeft},
                                              KeyCodeState{kWinKeyRight}};
   bool any_key_pressed_ = false;
 
   Connection* connection_;
-  ScopedObserver<EventDispatcher> dispatcher_;
-
-  uint8_t xcb_input_major_opcode_;
+  ScopedEventHandlers event_handlers_;
 
   DELETE_SPECIAL_MEMBERS(KeyListener);
 };
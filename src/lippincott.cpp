@@ -23,7 +23,14 @@
 #include "usage_error.h"
 #include "x_error.h"
 
+namespace {
+
+uint64_t g_lippincott_count = 0;
+
+}  // namespace
+
 void Lippincott() noexcept {
+  g_lippincott_count++;
   try {
     throw;
   } catch (const XError& x_error) {
@@ -36,3 +43,7 @@ void Lippincott() noexcept {
     std::cerr << "Unknown exception" << std::endl;
   }
 }
+
+auto LippincottCount() -> uint64_t {
+  return g_lippincott_count;
+}
@@ -17,4 +17,9 @@
 
 #pragma once
 
+#include <cstdint>
+
 void Lippincott() noexcept;
+
+// Returns how many exceptions Lippincott() has handled.
+auto LippincottCount() -> uint64_t;
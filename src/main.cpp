@@ -15,21 +15,74 @@
 // along with this program; if not, write to the Free Software Foundation,
 // Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 
+#include <iostream>
+#include <memory>
+
 #include "active_window_indicator.h"
+#include "allocation_counter.h"
 #include "command_line.h"
 #include "connection.h"
 #include "event_loop.h"
 #include "lippincott.h"
+#include "metrics_exporter.h"
 #include "quit_signaller.h"
+#include "recorder.h"
+#include "replay_server.h"
+#include "request_stats_dumper.h"
+#include "startup_info.h"
+#include "startup_profile.h"
+#include "tracer.h"
 
 auto main(int argc, char** argv) noexcept -> int {
   try {
+    AllocationCounter::set_phase(AllocationPhase::kStartup);
+    StartupProfile startup_profile;
     CommandLine command_line{argc, argv};
-    QuitSignaller quit_signaller;
-    Connection connection;
-    EventLoop loop{&connection, quit_signaller.fd()};
-    ActiveWindowIndicator indicator{&connection, &loop, &command_line};
+    std::unique_ptr<Tracer> tracer;
+    if (!command_line.trace_file().empty()) {
+      tracer = std::make_unique<Tracer>(command_line.trace_file());
+    }
+    std::unique_ptr<Recorder> recorder;
+    if (!command_line.record_file().empty()) {
+      recorder = std::make_unique<Recorder>(command_line.record_file());
+    }
+    std::unique_ptr<ReplayServer> replay_server;
+    if (!command_line.replay_file().empty()) {
+      replay_server =
+          std::make_unique<ReplayServer>(command_line.replay_file());
+    }
+    Connection connection{&command_line, replay_server.get()};
+    startup_profile.EndPhase("connect");
+    StartupInfo startup_info{&connection, &startup_profile};
+    if (tracer) {
+      tracer->set_xinput_major_opcode(startup_info.xinput_major_opcode());
+    }
+    EventLoop loop{&connection, &command_line};
+    QuitSignaller quit_signaller{&loop};
+    RequestStatsDumper request_stats_dumper{&loop, &connection};
+    ActiveWindowIndicator indicator{&connection, &loop, &command_line,
+                                    startup_info};
+    std::unique_ptr<MetricsExporter> metrics_exporter;
+    if (!command_line.metrics_socket().empty()) {
+      metrics_exporter = std::make_unique<MetricsExporter>(
+          &loop, &connection, &indicator, command_line.metrics_socket());
+    }
+    startup_profile.EndPhase("initialize");
+    if (command_line.startup_profile()) {
+      startup_profile.Print(std::cerr);
+    }
     loop.Run();
+    AllocationCounter::set_phase(AllocationPhase::kNone);
+    if (replay_server) {
+      replay_server->PrintSummary(std::cerr);
+    }
+    if (command_line.request_stats()) {
+      connection.request_stats().Print(std::cerr);
+      loop.dispatch_stats().Print(std::cerr);
+      if (AllocationCounter::enabled()) {
+        AllocationCounter::Print(std::cerr);
+      }
+    }
   } catch (...) {
     Lippincott();
     return 1;
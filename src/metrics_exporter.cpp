@@ -0,0 +1,349 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "metrics_exporter.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>  // IWYU pragma: keep (https://github.com/include-what-you-use/include-what-you-use/issues/277)
+#include <stdexcept>
+
+#include "active_window_indicator.h"
+#include "allocation_counter.h"
+#include "connection.h"
+#include "dispatch_stats.h"
+#include "event_loop.h"
+#include "event_priority.h"
+#include "histogram.h"
+#include "lippincott.h"
+#include "p_error.h"
+#include "request_stats.h"
+#include "scoped_fd.h"
+
+namespace {
+
+constexpr int kListenBacklog = 8;
+
+auto MakeAddress(const std::string& path) -> sockaddr_un {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument("Invalid metrics socket path: " + path);
+  }
+  path.copy(address.sun_path, path.size());
+  if (path[0] == '@') {
+    address.sun_path[0] = '\0';
+  }
+  return address;
+}
+
+// Returns true iff something accepts connections on the socket at
+// |address|.  Throws PError if that cannot be determined.
+auto SocketInUse(const sockaddr_un& address, socklen_t length) -> bool {
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    throw PError("socket");
+  }
+  ScopedFd probe(fd);
+  if (connect(probe.get(), reinterpret_cast<const sockaddr*>(&address),
+              length) == 0) {
+    return true;
+  }
+  switch (errno) {
+    case ECONNREFUSED:
+      // Nothing listens on it any more.
+      return false;
+    case EAGAIN:
+      // A listener whose backlog is full.
+      return true;
+    default:
+      throw PError("connect");
+  }
+}
+
+auto MakeListenSocket(const std::string& path) -> int {
+  auto address = MakeAddress(path);
+  // An abstract address is not NUL-terminated, so its length must be
+  // exact.
+  const auto length =
+      static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    throw PError("socket");
+  }
+  try {
+    // Replace the socket a previous instance left behind, but never
+    // anything else, nor the socket of an instance that is still running.
+    struct stat info {};
+    if (path[0] != '@' && lstat(path.c_str(), &info) == 0 &&
+        S_ISSOCK(info.st_mode)) {
+      if (SocketInUse(address, length)) {
+        throw std::runtime_error("Metrics socket " + path + " is in use");
+      }
+      if (unlink(path.c_str()) == -1) {
+        throw PError("unlink");
+      }
+    }
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), length) ==
+        -1) {
+      throw PError("bind");
+    }
+    if (listen(fd, kListenBacklog) == -1) {
+      throw PError("listen");
+    }
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  return fd;
+}
+
+class MetricsWriter {
+ public:
+  explicit MetricsWriter(std::ostream* stream) : stream_(stream) {}
+
+  void Family(const char* name, const char* type, const char* help) {
+    *stream_ << "# HELP xawi_" << name << ' ' << help << "\n# TYPE xawi_"
+             << name << ' ' << type << '\n';
+  }
+
+  // |labels| is empty or a comma separated list of name="value" pairs.
+  void Sample(const char* name, const std::string& labels, uint64_t value) {
+    *stream_ << "xawi_" << name;
+    if (!labels.empty()) {
+      *stream_ << '{' << labels << '}';
+    }
+    *stream_ << ' ' << value << '\n';
+  }
+
+  void HistogramSamples(const char* name,
+                        const std::string& labels,
+                        const Histogram& histogram) {
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+    uint64_t cumulative = 0;
+    // The last bucket also counts anything longer, so it becomes +Inf.
+    for (std::size_t i = 0; i + 1 < Histogram::kBuckets; i++) {
+      cumulative += histogram.bucket(i);
+      *stream_ << "xawi_" << name << "_bucket{" << prefix << "le=\""
+               << static_cast<double>(Histogram::BucketLimit(i)) / 1e6
+               << "\"} " << cumulative << '\n';
+    }
+    *stream_ << "xawi_" << name << "_bucket{" << prefix << "le=\"+Inf\"} "
+             << histogram.count() << '\n';
+    *stream_ << "xawi_" << name << "_sum";
+    if (!labels.empty()) {
+      *stream_ << '{' << labels << '}';
+    }
+    *stream_ << ' '
+             << std::chrono::duration<double>(histogram.sum()).count()
+             << '\n';
+    Sample((std::string(name) + "_count").c_str(), labels,
+           histogram.count());
+  }
+
+ private:
+  std::ostream* stream_;
+};
+
+auto SiteLabels(const RequestSite& site) -> std::string {
+  return "request=\"" + std::string(site.request) + "\",site=\"" +
+         site.file + ":" + std::to_string(site.line) + "\"";
+}
+
+auto PhaseLabels(AllocationPhase phase) -> std::string {
+  return std::string("phase=\"") + AllocationPhaseName(phase) + "\"";
+}
+
+}  // namespace
+
+MetricsExporter::MetricsExporter(EventLoop* event_loop,
+                                 Connection* connection,
+                                 const ActiveWindowIndicator* indicator,
+                                 const std::string& path)
+    : event_loop_(event_loop),
+      connection_(connection),
+      indicator_(indicator),
+      unlink_path_(path.empty() || path[0] == '@' ? "" : path),
+      fd_(MakeListenSocket(path)),
+      fd_watcher_(event_loop, fd_.get(), this) {}
+
+MetricsExporter::~MetricsExporter() {
+  if (!unlink_path_.empty()) {
+    unlink(unlink_path_.c_str());
+  }
+}
+
+void MetricsExporter::OnFdReadable() {
+  // The listening socket is edge triggered, so accept every pending
+  // connection.
+  while (true) {
+    int client_fd = accept4(fd_.get(), nullptr, nullptr,
+                            SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd == -1) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        return;
+      }
+      throw PError("accept4");
+    }
+    Serve(client_fd);
+    close(client_fd);
+  }
+}
+
+void MetricsExporter::Serve(int client_fd) {
+  // Discard whatever part of the request has arrived.  The response does
+  // not depend on it, and waiting for the rest would stall the loop.
+  std::array<char, 1024> request{};
+  while (REDO_ON_EINTR(static_cast<int>(
+             read(client_fd, request.data(), request.size()))) > 0) {
+  }
+
+  const std::string body = Render();
+  const std::string response =
+      "HTTP/1.0 200 OK\r\n"
+      "Content-Type: text/plain; version=0.0.4\r\n"
+      "Content-Length: " +
+      std::to_string(body.size()) + "\r\n\r\n" + body;
+
+  // The response fits in the socket buffer of a fresh connection.  If it
+  // does not, the scrape is cut short rather than blocking the loop.
+  std::size_t sent = 0;
+  while (sent < response.size()) {
+    auto size = send(client_fd, response.data() + sent,
+                     response.size() - sent, MSG_NOSIGNAL);
+    if (size == -1 && errno == EINTR) {
+      continue;
+    }
+    if (size <= 0) {
+      return;
+    }
+    sent += static_cast<std::size_t>(size);
+  }
+}
+
+auto MetricsExporter::Render() const -> std::string {
+  std::ostringstream stream;
+  MetricsWriter writer(&stream);
+
+  const auto& dispatch_stats = event_loop_->dispatch_stats();
+  writer.Family("events_dispatched_total", "counter",
+                "Events dispatched, by response type.");
+  for (std::size_t i = 0; i < DispatchStats::kNumResponseTypes; i++) {
+    const auto count = dispatch_stats.dispatched(static_cast<uint8_t>(i));
+    if (count != 0) {
+      writer.Sample("events_dispatched_total",
+                    "response_type=\"" + std::to_string(i) + "\"", count);
+    }
+  }
+  writer.Family("event_queueing_delay_seconds", "histogram",
+                "Time from draining an event to dispatching it.");
+  for (std::size_t i = 0; i < kNumEventPriorities; i++) {
+    const auto priority = static_cast<EventPriority>(i);
+    writer.HistogramSamples("event_queueing_delay_seconds",
+                            std::string("priority=\"") +
+                                EventPriorityName(priority) + "\"",
+                            dispatch_stats.queueing_delay(priority));
+  }
+  writer.Family("event_dispatch_seconds", "histogram",
+                "Time spent running the handlers of an event.");
+  writer.HistogramSamples("event_dispatch_seconds", "",
+                          dispatch_stats.dispatch_time());
+  writer.Family("forced_idle_passes_total", "counter",
+                "Idle passes forced by an event flood, by bound reached.");
+  writer.Sample("forced_idle_passes_total", "bound=\"events\"",
+                dispatch_stats.forced_idle_passes(
+                    DispatchStats::IdleBound::kEvents));
+  writer.Sample("forced_idle_passes_total", "bound=\"time\"",
+                dispatch_stats.forced_idle_passes(
+                    DispatchStats::IdleBound::kTime));
+
+  const auto& entries = connection_->request_stats().entries();
+  writer.Family("requests_total", "counter", "Requests sent, by call site.");
+  for (const auto& entry : entries) {
+    writer.Sample("requests_total", SiteLabels(entry.site),
+                  entry.counts.requests);
+  }
+  writer.Family("request_replies_total", "counter",
+                "Replies received, by call site.");
+  for (const auto& entry : entries) {
+    writer.Sample("request_replies_total", SiteLabels(entry.site),
+                  entry.counts.replies);
+  }
+  writer.Family("request_errors_total", "counter",
+                "Requests that failed, by call site.");
+  for (const auto& entry : entries) {
+    writer.Sample("request_errors_total", SiteLabels(entry.site),
+                  entry.counts.errors);
+  }
+  writer.Family("request_timeouts_total", "counter",
+                "Requests whose reply timed out, by call site.");
+  for (const auto& entry : entries) {
+    writer.Sample("request_timeouts_total", SiteLabels(entry.site),
+                  entry.counts.timeouts);
+  }
+  writer.Family("sync_round_trip_seconds", "histogram",
+                "Time the event loop blocked on a reply, by call site.");
+  for (const auto& entry : entries) {
+    writer.HistogramSamples("sync_round_trip_seconds", SiteLabels(entry.site),
+                            entry.sync_wait);
+  }
+
+  writer.Family("border_updates_total", "counter",
+                "Times the border was moved, resized, shown or hidden.");
+  writer.Sample("border_updates_total", "",
+                indicator_->border_window().updates());
+  writer.Family("active_window_changes_total", "counter",
+                "Times the active window changed.");
+  writer.Sample("active_window_changes_total", "",
+                indicator_->active_window_tracker().changes());
+  if (AllocationCounter::enabled()) {
+    writer.Family("allocations_total", "counter",
+                  "Calls to operator new, by phase.");
+    for (std::size_t i = 0; i < kNumAllocationPhases; i++) {
+      const auto phase = static_cast<AllocationPhase>(i);
+      writer.Sample("allocations_total", PhaseLabels(phase),
+                    AllocationCounter::Counts(phase).allocations);
+    }
+    writer.Family("allocated_bytes_total", "counter",
+                  "Bytes requested from operator new, by phase.");
+    for (std::size_t i = 0; i < kNumAllocationPhases; i++) {
+      const auto phase = static_cast<AllocationPhase>(i);
+      writer.Sample("allocated_bytes_total", PhaseLabels(phase),
+                    AllocationCounter::Counts(phase).bytes);
+    }
+  }
+  writer.Family("exceptions_total", "counter",
+                "Exceptions caught and logged.");
+  writer.Sample("exceptions_total", "", LippincottCount());
+
+  return stream.str();
+}
@@ -0,0 +1,64 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <string>
+
+#include "fd_watcher.h"
+#include "scoped_fd.h"
+#include "scoped_fd_watcher.h"
+#include "util.h"
+
+class ActiveWindowIndicator;
+class Connection;
+class EventLoop;
+
+// Serves counters and histograms in the Prometheus text format on a Unix
+// socket.  Each connection gets a single HTTP/1.0 response and is then
+// closed, so both `curl --unix-socket` and scrapers work.  Everything
+// happens on the event loop: a scrape costs one pass over the stats.
+class MetricsExporter : public FdWatcher {
+ public:
+  // |path| names a filesystem socket, or an abstract socket if it starts
+  // with '@'.  Throws PError if the socket cannot be bound.
+  MetricsExporter(EventLoop* event_loop,
+                  Connection* connection,
+                  const ActiveWindowIndicator* indicator,
+                  const std::string& path);
+  ~MetricsExporter() override;
+
+ protected:
+  // FdWatcher:
+  void OnFdReadable() override;
+
+ private:
+  void Serve(int client_fd);
+  [[nodiscard]] auto Render() const -> std::string;
+
+  EventLoop* event_loop_;
+  Connection* connection_;
+  const ActiveWindowIndicator* indicator_;
+
+  // Unlinked on destruction.  Empty for abstract sockets.
+  std::string unlink_path_;
+
+  ScopedFd fd_;
+  ScopedFdWatcher fd_watcher_;
+
+  DELETE_SPECIAL_MEMBERS(MetricsExporter);
+};
@@ -0,0 +1,47 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+// USDT probes for attaching bpftrace or perf to a running instance, e.g.
+//   bpftrace -e 'usdt:./x-active-window-indicator:dispatch__begin
+//                { @[arg0] = count(); }'
+// A probe is a single nop that a tracer patches when it attaches, so
+// arguments should be values that are already at hand.  Without
+// <sys/sdt.h> the probes compile to nothing.
+
+#if __has_include(<sys/sdt.h>)
+
+#include <sys/sdt.h>
+
+#define PROBE(name) DTRACE_PROBE(x_active_window_indicator, name)
+#define PROBE1(name, a) DTRACE_PROBE1(x_active_window_indicator, name, a)
+#define PROBE2(name, a, b) \
+  DTRACE_PROBE2(x_active_window_indicator, name, a, b)
+#define PROBE3(name, a, b, c) \
+  DTRACE_PROBE3(x_active_window_indicator, name, a, b, c)
+
+#else
+
+#define PROBE(name) \
+  do {              \
+  } while (0)
+#define PROBE1(name, a) PROBE(name)
+#define PROBE2(name, a, b) PROBE(name)
+#define PROBE3(name, a, b, c) PROBE(name)
+
+#endif
@@ -0,0 +1,64 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "property.h"
+
+#include <xcb/xcb.h>
+
+#include <climits>
+#include <cstdint>
+#include <limits>
+
+#include "connection.h"
+#include "x_error.h"
+
+auto RequestAtomArray(Connection* connection,
+                      xcb_window_t window,
+                      xcb_atom_t property) -> xcb_get_property_cookie_t {
+  return xcb_get_property(connection->connection(), false, window, property,
+                          XCB_ATOM_ATOM, 0,
+                          std::numeric_limits<uint32_t>::max());
+}
+
+auto RequestWindow(Connection* connection,
+                   xcb_window_t window,
+                   xcb_atom_t property) -> xcb_get_property_cookie_t {
+  return xcb_get_property(connection->connection(), false, window, property,
+                          XCB_ATOM_WINDOW, 0, sizeof(xcb_window_t));
+}
+
+auto AtomArrayFromReply(const xcb_get_property_reply_t& reply)
+    -> std::vector<xcb_atom_t> {
+  if (reply.format != CHAR_BIT * sizeof(xcb_atom_t) ||
+      reply.type != XCB_ATOM_ATOM || reply.bytes_after > 0) {
+    throw XError("Bad property reply");
+  }
+
+  const xcb_atom_t* value =
+      reinterpret_cast<xcb_atom_t*>(xcb_get_property_value(&reply));
+  return std::vector<xcb_atom_t>(value, value + reply.value_len);
+}
+
+auto WindowFromReply(const xcb_get_property_reply_t& reply) -> xcb_window_t {
+  if (reply.format != CHAR_BIT * sizeof(xcb_window_t) ||
+      reply.type != XCB_ATOM_WINDOW || reply.bytes_after > 0 ||
+      xcb_get_property_value_length(&reply) != sizeof(xcb_window_t)) {
+    throw XError("Bad property reply");
+  }
+
+  return reinterpret_cast<xcb_window_t*>(xcb_get_property_value(&reply))[0];
+}
@@ -0,0 +1,39 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xproto.h>
+
+#include <vector>
+
+class Connection;
+
+// Sends a GetProperty request for an ATOM[] property.
+auto RequestAtomArray(Connection* connection,
+                      xcb_window_t window,
+                      xcb_atom_t property) -> xcb_get_property_cookie_t;
+
+// Sends a GetProperty request for a WINDOW property.
+auto RequestWindow(Connection* connection,
+                   xcb_window_t window,
+                   xcb_atom_t property) -> xcb_get_property_cookie_t;
+
+// Throws XError if |reply| does not have the requested type.
+auto AtomArrayFromReply(const xcb_get_property_reply_t& reply)
+    -> std::vector<xcb_atom_t>;
+auto WindowFromReply(const xcb_get_property_reply_t& reply) -> xcb_window_t;
@@ -17,42 +17,16 @@
 
 #include "quit_signaller.h"
 
-#include <sys/signalfd.h>
-#include <unistd.h>
-
 #include <csignal>
-#include <cstdio>
-#include <cstdlib>
-#include <initializer_list>
-
-#include "p_error.h"
-#include "util.h"
 
-QuitSignaller::QuitSignaller() {
-  sigset_t mask;
-  sigemptyset(&mask);
-  for (auto sig : {
-           SIGHUP,
-           SIGINT,
-           SIGQUIT,
-           SIGTERM,
-       }) {
-    sigaddset(&mask, sig);
-  }
+#include "event_loop.h"
 
-  fd_ = signalfd(-1, &mask, SFD_CLOEXEC);
-  if (fd_ == -1) {
-    throw PError("signalfd");
-  }
+QuitSignaller::QuitSignaller(EventLoop* event_loop)
+    : Signaller(event_loop, {SIGHUP, SIGINT, SIGQUIT, SIGTERM}),
+      event_loop_(event_loop) {}
 
-  if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) {
-    throw PError("sigprocmask");
-  }
-}
+QuitSignaller::~QuitSignaller() = default;
 
-QuitSignaller::~QuitSignaller() {
-  if (REDO_ON_EINTR(close(fd_) == -1)) {
-    perror("close");
-    std::abort();
-  }
+void QuitSignaller::OnSignal(int /*signal*/) {
+  event_loop_->Quit();
 }
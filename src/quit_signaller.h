@@ -17,17 +17,23 @@
 
 #pragma once
 
+#include "signaller.h"
 #include "util.h"
 
-class QuitSignaller {
+class EventLoop;
+
+// Quits the event loop on SIGHUP, SIGINT, SIGQUIT and SIGTERM.
+class QuitSignaller : public Signaller {
  public:
-  QuitSignaller();
-  ~QuitSignaller();
+  explicit QuitSignaller(EventLoop* event_loop);
+  ~QuitSignaller() override;
 
-  [[nodiscard]] auto fd() const -> int { return fd_; }
+ protected:
+  // Signaller:
+  void OnSignal(int signal) override;
 
  private:
-  int fd_;
+  EventLoop* event_loop_;
 
   DELETE_SPECIAL_MEMBERS(QuitSignaller);
 };
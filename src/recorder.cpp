@@ -0,0 +1,122 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "recorder.h"
+
+#include <array>
+#include <cstring>
+
+#include "p_error.h"
+
+namespace {
+
+// Size of an event, an error or the fixed part of a reply on the wire.
+// XCB appends |full_sequence| to events and errors.
+constexpr std::size_t kPacketSize = 32;
+
+// Size of the fixed part of the setup reply, which ends with its length.
+constexpr std::size_t kSetupHeaderSize = 8;
+
+}  // namespace
+
+Recorder::Recorder(const std::string& path)
+    : file_(std::fopen(path.c_str(), "we")),
+      buffer_(std::make_unique<char[]>(kBufferSize)),
+      start_(std::chrono::steady_clock::now()) {
+  DCHECK(instance_ == nullptr);
+  if (file_ == nullptr) {
+    throw PError("fopen");
+  }
+  std::setvbuf(file_, buffer_.get(), _IOFBF, kBufferSize);
+  const RecordingHeader header{RecordingHeader::kMagic,
+                               RecordingHeader::kVersion};
+  std::fwrite(&header, sizeof(header), 1, file_);
+  instance_ = this;
+}
+
+Recorder::~Recorder() {
+  instance_ = nullptr;
+  std::fclose(file_);
+}
+
+void Recorder::RecordSetup(const xcb_setup_t& setup) {
+  Write(RecordType::kSetup, 0, &setup,
+        kSetupHeaderSize + std::size_t{setup.length} * 4);
+}
+
+void Recorder::RecordExtension(const char* name,
+                               const xcb_query_extension_reply_t& reply) {
+  Write(RecordType::kExtension, 0, &reply, sizeof(reply), name,
+        std::strlen(name));
+}
+
+void Recorder::RecordEvent(const xcb_generic_event_t& event) {
+  // XCB moves the data of generic events after |full_sequence|.
+  std::size_t extra = 0;
+  if ((event.response_type & ~0x80U) == XCB_GE_GENERIC) {
+    extra = std::size_t{
+                reinterpret_cast<const xcb_ge_generic_event_t&>(event).length} *
+            4;
+  }
+  Write(RecordType::kEvent, event.full_sequence, &event, kPacketSize,
+        &event + 1, extra);
+}
+
+void Recorder::RecordExpectReply(uint32_t sequence) {
+  Write(RecordType::kExpectReply, sequence, nullptr, 0);
+}
+
+void Recorder::RecordReply(uint32_t sequence,
+                           const void* reply,
+                           const xcb_generic_error_t* error) {
+  if (error != nullptr) {
+    Write(RecordType::kReply, sequence, error, kPacketSize);
+    return;
+  }
+  const auto* generic_reply = static_cast<const xcb_generic_reply_t*>(reply);
+  Write(RecordType::kReply, sequence, reply,
+        kPacketSize + std::size_t{generic_reply->length} * 4);
+}
+
+void Recorder::Flush() {
+  std::fflush(file_);
+}
+
+void Recorder::Write(RecordType type,
+                     uint32_t sequence,
+                     const void* head,
+                     std::size_t head_size,
+                     const void* tail,
+                     std::size_t tail_size) {
+  RecordHeader header{};
+  header.type = type;
+  header.size = CheckedCast<uint32_t>(head_size + tail_size);
+  header.sequence = sequence;
+  header.time_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start_)
+          .count());
+  std::fwrite(&header, sizeof(header), 1, file_);
+  if (head_size != 0) {
+    std::fwrite(head, head_size, 1, file_);
+  }
+  if (tail_size != 0) {
+    std::fwrite(tail, tail_size, 1, file_);
+  }
+  static constexpr std::array<char, kRecordAlignment> kZeros{};
+  std::fwrite(kZeros.data(), RecordPadding(header.size), 1, file_);
+}
@@ -0,0 +1,83 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <xcb/xcb.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "recording.h"
+#include "util.h"
+
+// Writes what the X server sends to a file that ReplayServer can play
+// back without a server: the connection setup, the events the loop reads
+// and the replies to requests.  Writes go through a large stdio buffer
+// that the event loop flushes before it blocks.
+class Recorder {
+ public:
+  // Throws PError if |path| cannot be opened.  Only one Recorder may
+  // exist at a time.
+  explicit Recorder(const std::string& path);
+  ~Recorder();
+
+  // Returns the active recorder, or null if recording is off.
+  static auto Get() -> Recorder* { return instance_; }
+
+  void RecordSetup(const xcb_setup_t& setup);
+  void RecordExtension(const char* name,
+                       const xcb_query_extension_reply_t& reply);
+
+  // |event| is laid out as XCB returns it, with |full_sequence| after the
+  // wire data.
+  void RecordEvent(const xcb_generic_event_t& event);
+
+  // Must be called when the reply to request |sequence| is first waited
+  // for or handed to a ReplyHandler, in the same order in every run.
+  void RecordExpectReply(uint32_t sequence);
+
+  // Exactly one of |reply| and |error| must be non-null.
+  void RecordReply(uint32_t sequence,
+                   const void* reply,
+                   const xcb_generic_error_t* error);
+
+  void Flush();
+
+ private:
+  static constexpr std::size_t kBufferSize = 1 << 20;
+
+  inline static Recorder* instance_ = nullptr;
+
+  // Writes a record whose payload is |head| followed by |tail|.
+  void Write(RecordType type,
+             uint32_t sequence,
+             const void* head,
+             std::size_t head_size,
+             const void* tail = nullptr,
+             std::size_t tail_size = 0);
+
+  std::FILE* file_;
+  std::unique_ptr<char[]> buffer_;
+  std::chrono::steady_clock::time_point start_;
+
+  DELETE_SPECIAL_MEMBERS(Recorder);
+};
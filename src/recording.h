@@ -0,0 +1,69 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the files written by Recorder and played back by
+// ReplayServer.  A file is a RecordingHeader followed by records, each a
+// RecordHeader and |size| bytes of payload padded to kRecordAlignment, so
+// that a mapped file can be walked in place.  Payloads are in the X
+// protocol wire format of the recording host.
+
+constexpr std::size_t kRecordAlignment = 8;
+
+struct RecordingHeader {
+  static constexpr uint32_t kMagic = 0x52574158;  // "XAWR"
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+};
+
+enum class RecordType : uint8_t {
+  // The connection setup reply.
+  kSetup,
+  // A QueryExtension reply followed by the name of the extension.
+  kExtension,
+  // An event or an error that was not a reply, as read by the event loop.
+  kEvent,
+  // No payload.  The client registered interest in the reply to request
+  // |sequence|.
+  kExpectReply,
+  // The reply or error for request |sequence|.
+  kReply,
+};
+
+struct RecordHeader {
+  RecordType type;
+  uint8_t pad[3];
+  uint32_t size;
+  // Full sequence number of the request or event.
+  uint32_t sequence;
+  uint32_t pad2;
+  // Nanoseconds since recording started.
+  uint64_t time_ns;
+};
+
+static_assert(sizeof(RecordingHeader) % kRecordAlignment == 0);
+static_assert(sizeof(RecordHeader) % kRecordAlignment == 0);
+
+constexpr auto RecordPadding(std::size_t size) -> std::size_t {
+  return (kRecordAlignment - size % kRecordAlignment) % kRecordAlignment;
+}
@@ -0,0 +1,476 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "replay_server.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <xcb/xcb.h>
+#include <xcb/xproto.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#include "p_error.h"
+#include "recording.h"
+
+namespace {
+
+// Size of an event, an error or the fixed part of a reply or request
+// header on the wire.
+constexpr std::size_t kPacketSize = 32;
+
+// |response_type| of replies.
+constexpr uint8_t kReplyType = 1;
+
+// Size of the fixed part of the connection setup request.
+constexpr std::size_t kSetupRequestSize = 12;
+
+// Size of the fixed part of a QueryExtension request, before the name.
+constexpr std::size_t kQueryExtensionSize = 8;
+
+auto SequenceBefore(uint32_t a, uint32_t b) -> bool {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+auto Pad4(std::size_t size) -> std::size_t {
+  return (size + 3) & ~std::size_t{3};
+}
+
+template <typename T>
+auto Read(const uint8_t* data) -> T {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+auto ToMilliseconds(std::chrono::nanoseconds duration) -> double {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+auto ThreadCpuTime() -> timespec {
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return time;
+}
+
+}  // namespace
+
+ReplayServer::ReplayServer(const std::string& path)
+    : start_(std::chrono::steady_clock::now()), start_cpu_(ThreadCpuTime()) {
+  try {
+    Load(path);
+    std::array<int, 2> fds{};
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds.data()) ==
+        -1) {
+      throw PError("socketpair");
+    }
+    server_fd_ = fds[0];
+    client_fd_ = fds[1];
+    if (fcntl(server_fd_, F_SETFL, O_NONBLOCK) == -1) {
+      throw PError("fcntl");
+    }
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ == -1) {
+      throw PError("eventfd");
+    }
+  } catch (...) {
+    Release();
+    throw;
+  }
+  thread_ = std::thread(&ReplayServer::Serve, this);
+}
+
+ReplayServer::~ReplayServer() {
+  stop_ = true;
+  const uint64_t wake = 1;
+  if (write(wake_fd_, &wake, sizeof(wake)) == -1) {
+    perror("write");
+    std::abort();
+  }
+  thread_.join();
+  Release();
+}
+
+auto ReplayServer::TakeClientFd() -> int {
+  DCHECK(client_fd_ != -1);
+  return std::exchange(client_fd_, -1);
+}
+
+void ReplayServer::ExpectReply(uint32_t sequence) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    expected_.push_back(sequence);
+  }
+  const uint64_t wake = 1;
+  if (write(wake_fd_, &wake, sizeof(wake)) == -1) {
+    throw PError("write");
+  }
+}
+
+void ReplayServer::PrintSummary(std::ostream& stream) const {
+  const auto wall = std::chrono::steady_clock::now() - start_;
+  const auto cpu_time = ThreadCpuTime();
+  const auto cpu = std::chrono::seconds{cpu_time.tv_sec - start_cpu_.tv_sec} +
+                   std::chrono::nanoseconds{cpu_time.tv_nsec -
+                                            start_cpu_.tv_nsec};
+  stream << "Replayed " << events_sent_ << " events and " << replies_sent_
+         << " replies in " << ToMilliseconds(wall) << " ms using "
+         << ToMilliseconds(cpu) << " ms of CPU time" << std::endl;
+}
+
+void ReplayServer::Load(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw PError("open");
+  }
+  struct stat info {};
+  if (fstat(fd, &info) == -1) {
+    close(fd);
+    throw PError("fstat");
+  }
+  mapping_size_ = static_cast<std::size_t>(info.st_size);
+  void* mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw PError("mmap");
+  }
+  mapping_ = static_cast<uint8_t*>(mapping);
+
+  const auto invalid = [&path]() {
+    return std::runtime_error("Invalid recording: " + path);
+  };
+  if (mapping_size_ < sizeof(RecordingHeader)) {
+    throw invalid();
+  }
+  const auto header = Read<RecordingHeader>(mapping_);
+  if (header.magic != RecordingHeader::kMagic ||
+      header.version != RecordingHeader::kVersion) {
+    throw invalid();
+  }
+
+  std::unordered_map<uint32_t, std::size_t> expect_indices;
+  std::size_t num_expected = 0;
+  std::vector<Packet> events;
+  std::vector<Packet> replies;
+  std::size_t offset = sizeof(RecordingHeader);
+  while (offset < mapping_size_) {
+    if (mapping_size_ - offset < sizeof(RecordHeader)) {
+      throw invalid();
+    }
+    const auto record = Read<RecordHeader>(mapping_ + offset);
+    offset += sizeof(RecordHeader);
+    if (record.size > mapping_size_ - offset) {
+      throw invalid();
+    }
+    uint8_t* payload = mapping_ + offset;
+    const bool has_packet = record.type == RecordType::kExtension ||
+                            record.type == RecordType::kEvent ||
+                            record.type == RecordType::kReply;
+    if (has_packet && record.size < kPacketSize) {
+      throw invalid();
+    }
+    switch (record.type) {
+      case RecordType::kSetup:
+        setup_ = payload;
+        setup_size_ = record.size;
+        break;
+      case RecordType::kExtension:
+        extensions_[std::string(reinterpret_cast<char*>(payload) + kPacketSize,
+                                record.size - kPacketSize)] = payload;
+        break;
+      case RecordType::kEvent:
+        events.push_back({payload, record.size, record.sequence, false, 0});
+        break;
+      case RecordType::kExpectReply:
+        expect_indices[record.sequence] = num_expected++;
+        break;
+      case RecordType::kReply: {
+        auto it = expect_indices.find(record.sequence);
+        if (it == expect_indices.end()) {
+          throw invalid();
+        }
+        replies.push_back(
+            {payload, record.size, record.sequence, true, it->second});
+        break;
+      }
+      default:
+        throw invalid();
+    }
+    offset += record.size + RecordPadding(record.size);
+  }
+  if (setup_ == nullptr) {
+    throw invalid();
+  }
+
+  // Replies were recorded in the order the client handled them, but the
+  // server sent them in request order, before any later event.
+  std::stable_sort(replies.begin(), replies.end(),
+                   [](const Packet& a, const Packet& b) {
+                     return SequenceBefore(a.sequence, b.sequence);
+                   });
+  packets_.reserve(events.size() + replies.size());
+  auto event = events.begin();
+  auto reply = replies.begin();
+  while (event != events.end() || reply != replies.end()) {
+    if (reply != replies.end() &&
+        (event == events.end() ||
+         !SequenceBefore(event->sequence, reply->sequence))) {
+      packets_.push_back(*reply++);
+    } else {
+      packets_.push_back(*event++);
+    }
+  }
+}
+
+void ReplayServer::Release() {
+  for (int fd : {server_fd_, client_fd_, wake_fd_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+void ReplayServer::Serve() {
+  while (!stop_) {
+    const bool writing = output_offset_ != output_.size();
+    std::array<pollfd, 2> fds{{
+        {server_fd_, static_cast<short>(POLLIN | (writing ? POLLOUT : 0)), 0},
+        {wake_fd_, POLLIN, 0},
+    }};
+    if (poll(fds.data(), fds.size(), -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("poll");
+      return;
+    }
+    if (fds[1].revents != 0) {
+      uint64_t wakes;
+      if (read(wake_fd_, &wakes, sizeof(wakes)) == -1 && errno != EAGAIN) {
+        perror("read");
+        return;
+      }
+    }
+    if (fds[0].revents != 0 && !ReadRequests()) {
+      return;
+    }
+    Advance();
+    if (!WriteOutput()) {
+      return;
+    }
+    if (!shut_down_ && Finished()) {
+      // Keep reading so that the client never blocks on a write.
+      shutdown(server_fd_, SHUT_WR);
+      shut_down_ = true;
+    }
+  }
+}
+
+auto ReplayServer::ReadRequests() -> bool {
+  std::array<uint8_t, 4096> buffer;
+  while (true) {
+    auto size = read(server_fd_, buffer.data(), buffer.size());
+    if (size > 0) {
+      input_.insert(input_.end(), buffer.begin(),
+                    buffer.begin() + size);
+      continue;
+    }
+    if (size == -1 && errno == EINTR) {
+      continue;
+    }
+    if (size == -1 && errno == EAGAIN) {
+      break;
+    }
+    return false;
+  }
+
+  std::size_t offset = 0;
+  if (!setup_sent_) {
+    if (input_.size() < kSetupRequestSize) {
+      return true;
+    }
+    const auto size = kSetupRequestSize +
+                      Pad4(Read<uint16_t>(input_.data() + 6)) +
+                      Pad4(Read<uint16_t>(input_.data() + 8));
+    if (input_.size() < size) {
+      return true;
+    }
+    offset = size;
+    output_.insert(output_.end(), setup_, setup_ + setup_size_);
+    setup_sent_ = true;
+  }
+
+  while (input_.size() - offset >= 4) {
+    std::size_t size = std::size_t{Read<uint16_t>(&input_[offset + 2])} * 4;
+    if (size == 0) {
+      // A BIG-REQUESTS request, though that extension is never offered.
+      if (input_.size() - offset < 8) {
+        break;
+      }
+      size = std::size_t{Read<uint32_t>(&input_[offset + 4])} * 4;
+      if (size < 8) {
+        return false;
+      }
+    }
+    if (input_.size() - offset < size) {
+      break;
+    }
+    requests_++;
+    HandleRequest(&input_[offset], size);
+    offset += size;
+  }
+  input_.erase(input_.begin(),
+               input_.begin() + static_cast<std::ptrdiff_t>(offset));
+  return true;
+}
+
+auto ReplayServer::WriteOutput() -> bool {
+  while (output_offset_ < output_.size()) {
+    auto size = send(server_fd_, output_.data() + output_offset_,
+                     output_.size() - output_offset_, MSG_NOSIGNAL);
+    if (size > 0) {
+      output_offset_ += static_cast<std::size_t>(size);
+      continue;
+    }
+    if (size == -1 && errno == EINTR) {
+      continue;
+    }
+    if (size == -1 && errno == EAGAIN) {
+      return true;
+    }
+    return false;
+  }
+  output_.clear();
+  output_offset_ = 0;
+  return true;
+}
+
+void ReplayServer::HandleRequest(const uint8_t* request, std::size_t size) {
+  std::vector<uint8_t> reply(kPacketSize);
+  reply[0] = kReplyType;
+  switch (request[0]) {
+    case XCB_QUERY_EXTENSION: {
+      if (size < kQueryExtensionSize) {
+        return;
+      }
+      const std::size_t name_size =
+          std::min<std::size_t>(Read<uint16_t>(request + 4),
+                                size - kQueryExtensionSize);
+      auto it = extensions_.find(std::string(
+          reinterpret_cast<const char*>(request) + kQueryExtensionSize,
+          name_size));
+      // Extensions missing from the recording are reported absent.
+      if (it != extensions_.end()) {
+        std::copy(it->second, it->second + kPacketSize, reply.begin());
+      }
+      break;
+    }
+    case XCB_GET_INPUT_FOCUS:
+      // XCB sends this to sync after many requests without replies.  The
+      // focus itself is never used.
+      break;
+    default:
+      return;
+  }
+  internal_replies_.push_back({requests_, std::move(reply)});
+}
+
+auto ReplayServer::ExpectedSequence(std::size_t index)
+    -> std::optional<uint32_t> {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index >= expected_.size()) {
+    return std::nullopt;
+  }
+  return expected_[index];
+}
+
+auto ReplayServer::PendingReplySequence() -> std::optional<uint32_t> {
+  next_reply_ = std::max(next_reply_, next_packet_);
+  while (next_reply_ < packets_.size() && !packets_[next_reply_].reply) {
+    next_reply_++;
+  }
+  if (next_reply_ == packets_.size()) {
+    return std::nullopt;
+  }
+  return ExpectedSequence(packets_[next_reply_].expect_index);
+}
+
+void ReplayServer::Advance() {
+  while (true) {
+    // A made up reply must not overtake a reply to an earlier request, or
+    // XCB would decide that request has no reply.
+    if (!internal_replies_.empty()) {
+      auto& internal = internal_replies_.front();
+      auto pending = PendingReplySequence();
+      if (!pending || SequenceBefore(internal.sequence, *pending)) {
+        Send(internal.data.data(), internal.data.size(), internal.sequence);
+        internal_replies_.pop_front();
+        continue;
+      }
+    }
+
+    if (next_packet_ == packets_.size()) {
+      return;
+    }
+    const auto& packet = packets_[next_packet_];
+    if (packet.reply) {
+      auto sequence = ExpectedSequence(packet.expect_index);
+      if (!sequence || SequenceBefore(requests_, *sequence)) {
+        return;
+      }
+      Send(packet.data, packet.size, *sequence);
+      replies_sent_++;
+    } else {
+      // Events carry the number of the last reply sent, so that XCB never
+      // concludes from an event that a pending request has no reply.
+      Send(packet.data, packet.size, last_sequence_);
+      events_sent_++;
+    }
+    next_packet_++;
+  }
+}
+
+void ReplayServer::Send(uint8_t* data, std::size_t size, uint32_t sequence) {
+  // KeymapNotify is the only packet without a sequence number.
+  if ((data[0] & 0x7f) != XCB_KEYMAP_NOTIFY) {
+    const auto low_bits = static_cast<uint16_t>(sequence);
+    std::memcpy(data + 2, &low_bits, sizeof(low_bits));
+  }
+  output_.insert(output_.end(), data, data + size);
+  last_sequence_ = sequence;
+}
+
+auto ReplayServer::Finished() const -> bool {
+  return next_packet_ == packets_.size() && internal_replies_.empty() &&
+         output_offset_ == output_.size();
+}
@@ -0,0 +1,149 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "in_process_server.h"
+#include "util.h"
+
+// Stands in for the X server by playing back a file written by Recorder
+// over a socket pair, so that a recorded session can be rerun as a
+// benchmark without a display.
+//
+// Requests only matter for their sequence numbers: the n-th reply the
+// client expects gets the reply recorded for the n-th expected request,
+// renumbered, once the request has arrived.  Packets go out in the order
+// the recorded server sent them, as fast as the client reads them.
+// QueryExtension and the GetInputFocus round trips that XCB makes on its
+// own are answered from the recording.  Once everything was sent the
+// socket is shut down, which ends the event loop.
+//
+// The server runs on its own thread because the client blocks on replies
+// outside the event loop.
+class ReplayServer : public InProcessServer {
+ public:
+  // Throws PError if |path| cannot be mapped and std::runtime_error if it
+  // is not a valid recording.
+  explicit ReplayServer(const std::string& path);
+  ~ReplayServer() override;
+
+  // InProcessServer:
+  [[nodiscard]] auto TakeClientFd() -> int override;
+  void ExpectReply(uint32_t sequence) override;
+
+  // Prints how many packets were played back, and the wall and CPU time
+  // that the calling thread took since construction.
+  void PrintSummary(std::ostream& stream) const;
+
+ private:
+  struct Packet {
+    uint8_t* data;
+    uint32_t size;
+    // The sequence number in the recording.
+    uint32_t sequence;
+    bool reply;
+    // For replies, the index of the request among the expected ones.
+    std::size_t expect_index;
+  };
+
+  // A reply the server makes up instead of playing back.
+  struct InternalReply {
+    uint32_t sequence;
+    std::vector<uint8_t> data;
+  };
+
+  void Load(const std::string& path);
+  void Serve();
+
+  // Closes the descriptors and unmaps the recording.
+  void Release();
+
+  // Returns false once the client has disconnected.
+  auto ReadRequests() -> bool;
+  auto WriteOutput() -> bool;
+
+  void HandleRequest(const uint8_t* request, std::size_t size);
+
+  // Returns the sequence number of the |index|-th expected reply, or
+  // nullopt if ExpectReply() was not called for it yet.
+  auto ExpectedSequence(std::size_t index) -> std::optional<uint32_t>;
+
+  // Returns the sequence number of the next reply to be played back, or
+  // nullopt if there is none or it is not known yet.
+  auto PendingReplySequence() -> std::optional<uint32_t>;
+
+  // Queues every packet and internal reply that may be sent now.
+  void Advance();
+  void Send(uint8_t* data, std::size_t size, uint32_t sequence);
+
+  [[nodiscard]] auto Finished() const -> bool;
+
+  // Mapped privately so that sequence numbers can be rewritten in place.
+  uint8_t* mapping_ = nullptr;
+  std::size_t mapping_size_ = 0;
+
+  // Parsed from the mapping, then only used by the server thread.
+  uint8_t* setup_ = nullptr;
+  std::size_t setup_size_ = 0;
+  std::unordered_map<std::string, const uint8_t*> extensions_;
+  std::vector<Packet> packets_;
+
+  int server_fd_ = -1;
+  int client_fd_ = -1;
+  int wake_fd_ = -1;
+
+  // Only used by the server thread.
+  std::vector<uint8_t> input_;
+  std::vector<uint8_t> output_;
+  std::size_t output_offset_ = 0;
+  bool setup_sent_ = false;
+  bool shut_down_ = false;
+  uint32_t requests_ = 0;
+  uint32_t last_sequence_ = 0;
+  std::size_t next_packet_ = 0;
+  std::size_t next_reply_ = 0;
+  std::deque<InternalReply> internal_replies_;
+
+  // Sequence numbers passed to ExpectReply(), in order.
+  std::mutex mutex_;
+  std::vector<uint32_t> expected_;
+
+  std::atomic<bool> stop_ = false;
+  std::atomic<uint64_t> events_sent_ = 0;
+  std::atomic<uint64_t> replies_sent_ = 0;
+
+  std::chrono::steady_clock::time_point start_;
+  timespec start_cpu_{};
+
+  std::thread thread_;
+
+  DELETE_SPECIAL_MEMBERS(ReplayServer);
+};
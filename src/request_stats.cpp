@@ -0,0 +1,108 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "request_stats.h"
+
+#include <cstring>
+#include <ostream>
+
+namespace {
+
+void Add(RequestCounts* sum, const RequestCounts& counts) {
+  sum->requests += counts.requests;
+  sum->replies += counts.replies;
+  sum->errors += counts.errors;
+  sum->timeouts += counts.timeouts;
+  sum->sync_round_trips += counts.sync_round_trips;
+}
+
+}  // namespace
+
+RequestStats::RequestStats() = default;
+
+RequestStats::~RequestStats() = default;
+
+void RequestStats::RecordRequest(const RequestSite& site) {
+  EntryFor(site)->counts.requests++;
+}
+
+void RequestStats::RecordReply(const RequestSite& site) {
+  EntryFor(site)->counts.replies++;
+}
+
+void RequestStats::RecordError(const RequestSite& site) {
+  EntryFor(site)->counts.errors++;
+}
+
+void RequestStats::RecordTimeout(const RequestSite& site) {
+  EntryFor(site)->counts.timeouts++;
+}
+
+void RequestStats::RecordSyncWait(const RequestSite& site,
+                                  std::chrono::nanoseconds duration) {
+  auto* entry = EntryFor(site);
+  entry->counts.sync_round_trips++;
+  entry->sync_wait.Record(duration);
+}
+
+auto RequestStats::Totals() const -> RequestCounts {
+  RequestCounts sum;
+  for (const auto& entry : entries_) {
+    Add(&sum, entry.counts);
+  }
+  return sum;
+}
+
+auto RequestStats::CountsFor(const char* request) const -> RequestCounts {
+  RequestCounts sum;
+  for (const auto& entry : entries_) {
+    if (std::strcmp(entry.site.request, request) == 0) {
+      Add(&sum, entry.counts);
+    }
+  }
+  return sum;
+}
+
+void RequestStats::Print(std::ostream& stream) const {
+  for (const auto& entry : entries_) {
+    const auto& counts = entry.counts;
+    stream << entry.site.request << " (" << entry.site.file << ":"
+           << entry.site.line << "): requests=" << counts.requests
+           << " replies=" << counts.replies << " errors=" << counts.errors
+           << " timeouts=" << counts.timeouts
+           << " sync_round_trips=" << counts.sync_round_trips;
+    if (entry.sync_wait.count() > 0) {
+      stream << " sync_wait_us(p50<" << entry.sync_wait.Quantile(0.5)
+             << " p99<" << entry.sync_wait.Quantile(0.99) << " max<"
+             << entry.sync_wait.Quantile(1.0) << ")";
+    }
+    stream << '\n';
+  }
+  stream.flush();
+}
+
+auto RequestStats::EntryFor(const RequestSite& site) -> Entry* {
+  for (auto& entry : entries_) {
+    if (entry.site.line == site.line &&
+        std::strcmp(entry.site.file, site.file) == 0 &&
+        std::strcmp(entry.site.request, site.request) == 0) {
+      return &entry;
+    }
+  }
+  entries_.push_back(Entry{site, {}, {}});
+  return &entries_.back();
+}
@@ -0,0 +1,84 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include "histogram.h"
+#include "request_site.h"
+#include "util.h"
+
+struct RequestCounts {
+  uint64_t requests = 0;
+  uint64_t replies = 0;
+  uint64_t errors = 0;
+  uint64_t timeouts = 0;
+
+  // Number of replies the event loop blocked on.
+  uint64_t sync_round_trips = 0;
+};
+
+// Counts requests and their outcomes per call site.  Since a call site
+// always sends the same request, this also breaks the counts down by
+// major and minor opcode.  Only requests sent through Connection are
+// counted, which includes void requests sent with XCB_VOID.
+class RequestStats {
+ public:
+  struct Entry {
+    RequestSite site;
+    RequestCounts counts;
+
+    // How long the event loop blocked on each synchronous reply.
+    Histogram sync_wait;
+  };
+
+  RequestStats();
+  ~RequestStats();
+
+  void RecordRequest(const RequestSite& site);
+  void RecordReply(const RequestSite& site);
+  void RecordError(const RequestSite& site);
+  void RecordTimeout(const RequestSite& site);
+  void RecordSyncWait(const RequestSite& site,
+                      std::chrono::nanoseconds duration);
+
+  // Returns the sum of the counts of all call sites.
+  [[nodiscard]] auto Totals() const -> RequestCounts;
+
+  // Returns the sum of the counts of all call sites that sent |request|,
+  // e.g. "xcb_get_geometry".
+  [[nodiscard]] auto CountsFor(const char* request) const -> RequestCounts;
+
+  [[nodiscard]] auto entries() const -> const std::vector<Entry>& {
+    return entries_;
+  }
+
+  void Print(std::ostream& stream) const;
+
+ private:
+  auto EntryFor(const RequestSite& site) -> Entry*;
+
+  // There are only a handful of call sites, so a linear search beats
+  // hashing.
+  std::vector<Entry> entries_;
+
+  DELETE_SPECIAL_MEMBERS(RequestStats);
+};
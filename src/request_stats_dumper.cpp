@@ -0,0 +1,43 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "request_stats_dumper.h"
+
+#include <csignal>
+#include <iostream>
+
+#include "allocation_counter.h"
+#include "connection.h"
+#include "dispatch_stats.h"
+#include "event_loop.h"
+#include "request_stats.h"
+
+RequestStatsDumper::RequestStatsDumper(EventLoop* event_loop,
+                                       Connection* connection)
+    : Signaller(event_loop, {SIGUSR1}),
+      event_loop_(event_loop),
+      connection_(connection) {}
+
+RequestStatsDumper::~RequestStatsDumper() = default;
+
+void RequestStatsDumper::OnSignal(int /*signal*/) {
+  connection_->request_stats().Print(std::cerr);
+  event_loop_->dispatch_stats().Print(std::cerr);
+  if (AllocationCounter::enabled()) {
+    AllocationCounter::Print(std::cerr);
+  }
+}
@@ -0,0 +1,42 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include "signaller.h"
+#include "util.h"
+
+class Connection;
+class EventLoop;
+
+// Prints the connection's RequestStats and the loop's DispatchStats on
+// SIGUSR1.
+class RequestStatsDumper : public Signaller {
+ public:
+  RequestStatsDumper(EventLoop* event_loop, Connection* connection);
+  ~RequestStatsDumper() override;
+
+ protected:
+  // Signaller:
+  void OnSignal(int signal) override;
+
+ private:
+  EventLoop* event_loop_;
+  Connection* connection_;
+
+  DELETE_SPECIAL_MEMBERS(RequestStatsDumper);
+};
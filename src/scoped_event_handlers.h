@@ -0,0 +1,49 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <initializer_list>
+#include <vector>
+
+#include "event_handler.h"
+#include "event_loop.h"
+#include "event_router.h"
+#include "util.h"
+
+class ScopedEventHandlers {
+ public:
+  ScopedEventHandlers(EventLoop* event_loop,
+                      std::initializer_list<EventHandler> handlers)
+      : router_(event_loop->event_router()), handlers_(handlers) {
+    for (const auto& handler : handlers_) {
+      router_->AddHandler(handler);
+    }
+  }
+
+  ~ScopedEventHandlers() {
+    for (const auto& handler : handlers_) {
+      router_->RemoveHandler(handler);
+    }
+  }
+
+ private:
+  EventRouter* router_;
+  std::vector<EventHandler> handlers_;
+
+  DELETE_SPECIAL_MEMBERS(ScopedEventHandlers);
+};
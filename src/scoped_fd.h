@@ -0,0 +1,47 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+#include "util.h"
+
+// Closes a file descriptor on destruction.  Declare it before any
+// ScopedFdWatcher of the descriptor so that the watch is removed first.
+class ScopedFd {
+ public:
+  explicit ScopedFd(int fd) : fd_(fd) {}
+
+  ~ScopedFd() {
+    if (REDO_ON_EINTR(close(fd_) == -1)) {
+      perror("close");
+      std::abort();
+    }
+  }
+
+  [[nodiscard]] auto get() const -> int { return fd_; }
+
+ private:
+  int fd_;
+
+  DELETE_SPECIAL_MEMBERS(ScopedFd);
+};
@@ -0,0 +1,72 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "signaller.h"
+
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#include "p_error.h"
+
+namespace {
+
+auto MakeSignalFd(std::initializer_list<int> signals) -> int {
+  sigset_t mask;
+  sigemptyset(&mask);
+  for (auto sig : signals) {
+    sigaddset(&mask, sig);
+  }
+
+  int fd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+  if (fd == -1) {
+    throw PError("signalfd");
+  }
+
+  if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) {
+    throw PError("sigprocmask");
+  }
+  return fd;
+}
+
+}  // namespace
+
+Signaller::Signaller(EventLoop* event_loop, std::initializer_list<int> signals)
+    : fd_(MakeSignalFd(signals)), fd_watcher_(event_loop, fd_.get(), this) {}
+
+Signaller::~Signaller() = default;
+
+void Signaller::OnFdReadable() {
+  while (true) {
+    struct signalfd_siginfo info {};
+    auto size = read(fd_.get(), &info, sizeof(info));
+    if (size == -1 && errno == EINTR) {
+      continue;
+    }
+    if (size == -1 && errno == EAGAIN) {
+      return;
+    }
+    if (size != sizeof(info)) {
+      throw PError("read");
+    }
+    OnSignal(CheckedCast<int>(info.ssi_signo));
+  }
+}
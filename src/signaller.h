@@ -0,0 +1,46 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <initializer_list>
+
+#include "fd_watcher.h"
+#include "scoped_fd.h"
+#include "scoped_fd_watcher.h"
+#include "util.h"
+
+class EventLoop;
+
+// Blocks |signals| and delivers them through the event loop instead.
+class Signaller : public FdWatcher {
+ public:
+  Signaller(EventLoop* event_loop, std::initializer_list<int> signals);
+  ~Signaller() override;
+
+ protected:
+  virtual void OnSignal(int signal) = 0;
+
+  // FdWatcher:
+  void OnFdReadable() override;
+
+ private:
+  ScopedFd fd_;
+  ScopedFdWatcher fd_watcher_;
+
+  DELETE_SPECIAL_MEMBERS(Signaller);
+};
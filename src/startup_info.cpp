@@ -0,0 +1,105 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "startup_info.h"
+
+#include <xcb/xcb.h>
+#include <xcb/xfixes.h>
+#include <xcb/xinput.h>
+#include <xcb/xproto.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+#include "property.h"
+#include "startup_profile.h"
+#include "x_error.h"
+
+namespace {
+
+auto InternAtom(Connection* connection, const std::string& str)
+    -> xcb_intern_atom_cookie_t {
+  return xcb_intern_atom(connection->connection(), false,
+                         CheckedCast<uint16_t>(str.length()), str.c_str());
+}
+
+auto GetExtension(Connection* connection,
+                  xcb_extension_t* extension,
+                  const std::string& name)
+    -> const xcb_query_extension_reply_t* {
+  // The reply was prefetched, so this only blocks if it has not arrived yet.
+  const auto* reply = connection->ExtensionData(extension);
+  if (reply == nullptr || reply->present == 0U) {
+    throw XError(name + " not available");
+  }
+  return reply;
+}
+
+}  // namespace
+
+StartupInfo::StartupInfo(Connection* connection, StartupProfile* profile)
+    : connection_(connection) {
+  auto* c = connection_->connection();
+  const xcb_window_t root = connection_->root_window();
+
+  xcb_prefetch_extension_data(c, &xcb_xfixes_id);
+  xcb_prefetch_extension_data(c, &xcb_input_id);
+  auto net_supported_cookie = InternAtom(connection_, "_NET_SUPPORTED");
+  auto net_active_window_cookie =
+      InternAtom(connection_, "_NET_ACTIVE_WINDOW");
+
+  xcb_atom_t net_supported =
+      XCB_REPLY(xcb_intern_atom, connection_, net_supported_cookie)->atom;
+  net_active_window_ =
+      XCB_REPLY(xcb_intern_atom, connection_, net_active_window_cookie)->atom;
+  GetExtension(connection_, &xcb_xfixes_id, "XFIXES");
+  xinput_major_opcode_ =
+      GetExtension(connection_, &xcb_input_id, "XINPUT")->major_opcode;
+  profile->EndPhase("extensions and atoms");
+
+  // Select property changes before reading _NET_ACTIVE_WINDOW so that no
+  // change is missed before ActiveWindowTracker starts listening.
+  connection_->SelectEvents(root, XCB_EVENT_MASK_PROPERTY_CHANGE);
+
+  auto xfixes_version_cookie = xcb_xfixes_query_version(
+      c, XCB_XFIXES_MAJOR_VERSION, XCB_XFIXES_MINOR_VERSION);
+  auto xinput_version_cookie = xcb_input_xi_query_version(
+      c, XCB_INPUT_MAJOR_VERSION, XCB_INPUT_MINOR_VERSION);
+  auto net_supported_property_cookie =
+      RequestAtomArray(connection_, root, net_supported);
+  auto active_window_cookie =
+      RequestWindow(connection_, root, net_active_window_);
+
+  XCB_REPLY(xcb_xfixes_query_version, connection_, xfixes_version_cookie);
+  XCB_REPLY(xcb_input_xi_query_version, connection_, xinput_version_cookie);
+  auto atoms = AtomArrayFromReply(*XCB_REPLY(
+      xcb_get_property, connection_, net_supported_property_cookie));
+  if (std::find(atoms.begin(), atoms.end(), net_active_window_) ==
+      atoms.end()) {
+    throw XError("WM does not support active window");
+  }
+  active_window_ = WindowFromReply(
+      *XCB_REPLY(xcb_get_property, connection_, active_window_cookie));
+  profile->EndPhase("versions and properties");
+}
+
+StartupInfo::~StartupInfo() {
+  connection_->DeselectEvents(connection_->root_window(),
+                              XCB_EVENT_MASK_PROPERTY_CHANGE);
+}
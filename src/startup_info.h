@@ -0,0 +1,57 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <cstdint>
+
+#include "util.h"
+
+using xcb_atom_t = std::uint32_t;
+using xcb_window_t = std::uint32_t;
+
+class Connection;
+class StartupProfile;
+
+// Server state needed by the indicator's components.  All requests are
+// sent before any reply is waited on, so the whole startup costs two
+// round trips: one for the extensions and atoms, and one for the
+// extension versions and root window properties that depend on them.
+class StartupInfo {
+ public:
+  StartupInfo(Connection* connection, StartupProfile* profile);
+  ~StartupInfo();
+
+  [[nodiscard]] auto net_active_window() const -> xcb_atom_t {
+    return net_active_window_;
+  }
+  [[nodiscard]] auto active_window() const -> xcb_window_t {
+    return active_window_;
+  }
+  [[nodiscard]] auto xinput_major_opcode() const -> uint8_t {
+    return xinput_major_opcode_;
+  }
+
+ private:
+  Connection* connection_;
+
+  xcb_atom_t net_active_window_;
+  xcb_window_t active_window_;
+  uint8_t xinput_major_opcode_;
+
+  DELETE_SPECIAL_MEMBERS(StartupInfo);
+};
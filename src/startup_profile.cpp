@@ -0,0 +1,54 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "startup_profile.h"
+
+#include <iomanip>
+#include <ostream>
+
+namespace {
+
+auto ToMilliseconds(std::chrono::steady_clock::duration duration) -> double {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}  // namespace
+
+StartupProfile::StartupProfile()
+    : start_(Clock::now()), phase_start_(start_) {}
+
+StartupProfile::~StartupProfile() = default;
+
+void StartupProfile::EndPhase(const char* name) {
+  auto now = Clock::now();
+  phases_.emplace_back(name, now - phase_start_);
+  phase_start_ = now;
+}
+
+void StartupProfile::Print(std::ostream& stream) const {
+  auto flags = stream.flags();
+  auto precision = stream.precision();
+  stream << std::fixed << std::setprecision(3);
+  for (const auto& [name, duration] : phases_) {
+    stream << "startup: " << std::setw(10) << ToMilliseconds(duration)
+           << " ms  " << name << '\n';
+  }
+  stream << "startup: " << std::setw(10)
+         << ToMilliseconds(phase_start_ - start_) << " ms  total" << std::endl;
+  stream.flags(flags);
+  stream.precision(precision);
+}
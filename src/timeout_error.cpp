@@ -0,0 +1,39 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "timeout_error.h"
+
+#include <sstream>
+#include <string>
+
+#include "request_site.h"
+
+namespace {
+
+auto MakeErrorMessage(const RequestSite& site,
+                      std::chrono::milliseconds waited) -> std::string {
+  std::ostringstream stream;
+  stream << "Request " << site.request << " from " << site.file << ":"
+         << site.line << " timed out after " << waited.count() << " ms";
+  return stream.str();
+}
+
+}  // namespace
+
+TimeoutError::TimeoutError(const RequestSite& site,
+                           std::chrono::milliseconds waited)
+    : XError(MakeErrorMessage(site, waited)) {}
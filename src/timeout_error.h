@@ -17,15 +17,13 @@
 
 #pragma once
 
-#include "util.h"
+#include <chrono>
 
-class Event;
+#include "x_error.h"
 
-class EventDispatcher {
- public:
-  // Returns true iff the event was handled.
-  virtual auto DispatchEvent(const Event& event) -> bool = 0;
+struct RequestSite;
 
- protected:
-  DEFAULT_VIRTUAL_DESTRUCTOR_AND_SPECIAL_MEMBERS(EventDispatcher);
+class TimeoutError : public XError {
+ public:
+  TimeoutError(const RequestSite& site, std::chrono::milliseconds waited);
 };
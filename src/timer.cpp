@@ -0,0 +1,41 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "timer.h"
+
+#include <utility>
+
+#include "event_loop.h"
+#include "timer_queue.h"
+
+Timer::Timer(EventLoop* event_loop, std::function<void()> callback)
+    : queue_(event_loop->timer_queue()), callback_(std::move(callback)) {}
+
+Timer::~Timer() {
+  Stop();
+}
+
+void Timer::Start(Clock::duration delay) {
+  deadline_ = Clock::now() + delay;
+  queue_->Schedule(this);
+}
+
+void Timer::Stop() {
+  if (running()) {
+    queue_->Unschedule(this);
+  }
+}
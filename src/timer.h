@@ -0,0 +1,63 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <limits>
+
+#include "util.h"
+
+class EventLoop;
+class TimerQueue;
+
+// A one-shot timer run by the event loop.  The callback may restart the
+// timer to make it periodic.
+class Timer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  Timer(EventLoop* event_loop, std::function<void()> callback);
+  ~Timer();
+
+  // Runs the callback once |delay| has passed, replacing any earlier
+  // deadline.
+  void Start(Clock::duration delay);
+
+  void Stop();
+
+  [[nodiscard]] auto running() const -> bool {
+    return heap_index_ != kNotQueued;
+  }
+
+ private:
+  friend class TimerQueue;
+
+  static constexpr std::size_t kNotQueued =
+      std::numeric_limits<std::size_t>::max();
+
+  TimerQueue* queue_;
+  std::function<void()> callback_;
+  Clock::time_point deadline_;
+
+  // Position in the queue's heap, or kNotQueued if stopped.
+  std::size_t heap_index_ = kNotQueued;
+
+  DELETE_SPECIAL_MEMBERS(Timer);
+};
@@ -0,0 +1,166 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "timer_queue.h"
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "lippincott.h"
+#include "p_error.h"
+#include "timer.h"
+
+TimerQueue::TimerQueue()
+    : fd_(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)) {
+  if (fd_ == -1) {
+    throw PError("timerfd_create");
+  }
+}
+
+TimerQueue::~TimerQueue() {
+  DCHECK(heap_.empty());
+  if (REDO_ON_EINTR(close(fd_) == -1)) {
+    perror("close");
+    std::abort();
+  }
+}
+
+void TimerQueue::Schedule(Timer* timer) {
+  if (timer->running()) {
+    SiftUp(timer->heap_index_);
+    SiftDown(timer->heap_index_);
+  } else {
+    heap_.push_back(timer);
+    timer->heap_index_ = heap_.size() - 1;
+    SiftUp(timer->heap_index_);
+  }
+  Arm();
+}
+
+void TimerQueue::Unschedule(Timer* timer) {
+  auto index = timer->heap_index_;
+  timer->heap_index_ = Timer::kNotQueued;
+  Timer* last = heap_.back();
+  heap_.pop_back();
+  if (last != timer) {
+    Place(index, last);
+    SiftUp(index);
+    SiftDown(last->heap_index_);
+  }
+  Arm();
+}
+
+void TimerQueue::OnFdReadable() {
+  uint64_t expirations;
+  if (REDO_ON_EINTR(static_cast<int>(
+          read(fd_, &expirations, sizeof(expirations)))) == -1 &&
+      errno != EAGAIN) {
+    throw PError("read");
+  }
+  armed_deadline_.reset();
+
+  // Timers restarted by a callback run no earlier than the next wakeup,
+  // even with a zero delay.
+  auto now = Clock::now();
+  running_timers_ = true;
+  while (!heap_.empty() && heap_.front()->deadline_ <= now) {
+    Timer* timer = heap_.front();
+    Unschedule(timer);
+    try {
+      timer->callback_();
+    } catch (...) {
+      Lippincott();
+    }
+  }
+  running_timers_ = false;
+  Arm();
+}
+
+void TimerQueue::SiftUp(std::size_t index) {
+  Timer* timer = heap_[index];
+  while (index > 0) {
+    auto parent = (index - 1) / 2;
+    if (heap_[parent]->deadline_ <= timer->deadline_) {
+      break;
+    }
+    Place(index, heap_[parent]);
+    index = parent;
+  }
+  Place(index, timer);
+}
+
+void TimerQueue::SiftDown(std::size_t index) {
+  Timer* timer = heap_[index];
+  while (true) {
+    auto child = 2 * index + 1;
+    if (child >= heap_.size()) {
+      break;
+    }
+    if (child + 1 < heap_.size() &&
+        heap_[child + 1]->deadline_ < heap_[child]->deadline_) {
+      child++;
+    }
+    if (timer->deadline_ <= heap_[child]->deadline_) {
+      break;
+    }
+    Place(index, heap_[child]);
+    index = child;
+  }
+  Place(index, timer);
+}
+
+void TimerQueue::Place(std::size_t index, Timer* timer) {
+  heap_[index] = timer;
+  timer->heap_index_ = index;
+}
+
+void TimerQueue::Arm() {
+  if (running_timers_) {
+    return;
+  }
+  std::optional<Clock::time_point> deadline;
+  if (!heap_.empty()) {
+    deadline = heap_.front()->deadline_;
+  }
+  if (deadline == armed_deadline_) {
+    return;
+  }
+
+  // An all-zero it_value disarms the timer.
+  struct itimerspec spec {};
+  if (deadline) {
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        deadline->time_since_epoch());
+    auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    spec.it_value.tv_sec = CheckedCast<time_t>(seconds.count());
+    spec.it_value.tv_nsec = CheckedCast<long>((since_epoch - seconds).count());
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+      spec.it_value.tv_nsec = 1;
+    }
+  }
+  if (timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+    throw PError("timerfd_settime");
+  }
+  armed_deadline_ = deadline;
+}
@@ -0,0 +1,68 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "fd_watcher.h"
+#include "util.h"
+
+class Timer;
+
+// Multiplexes every Timer onto a single timerfd.  The timers are kept in
+// a min-heap by deadline and the timerfd is armed for the earliest one,
+// or disarmed when none are running so that an idle loop never wakes up.
+class TimerQueue : public FdWatcher {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  TimerQueue();
+  ~TimerQueue() override;
+
+  [[nodiscard]] auto fd() const -> int { return fd_; }
+
+  // Inserts |timer| or moves it to its new deadline.
+  void Schedule(Timer* timer);
+  void Unschedule(Timer* timer);
+
+  // FdWatcher:
+  void OnFdReadable() override;
+
+ private:
+  void SiftUp(std::size_t index);
+  void SiftDown(std::size_t index);
+  void Place(std::size_t index, Timer* timer);
+
+  // Points the timerfd at the earliest deadline, if it changed.
+  void Arm();
+
+  int fd_;
+  std::vector<Timer*> heap_;
+
+  // The deadline the timerfd will next fire at, if armed.
+  std::optional<Clock::time_point> armed_deadline_;
+
+  // Set while expired timers are run so that each Schedule() from a
+  // callback does not reprogram the timerfd.
+  bool running_timers_ = false;
+
+  DELETE_SPECIAL_MEMBERS(TimerQueue);
+};
@@ -0,0 +1,172 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#include "tracer.h"
+
+#include <unistd.h>
+#include <xcb/xcb.h>
+#include <xcb/xinput.h>
+#include <xcb/xproto.h>
+
+#include "event.h"
+#include "p_error.h"
+
+namespace {
+
+auto Microseconds(Tracer::Clock::time_point time) -> long long {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+template <typename XEvent>
+auto As(const Event& event) -> const XEvent* {
+  return reinterpret_cast<const XEvent*>(event.event());
+}
+
+// Returns true iff |event_type| is an XI2 device event, all of which
+// share the layout of key presses.
+auto IsXiDeviceEvent(uint16_t event_type) -> bool {
+  switch (event_type) {
+    case XCB_INPUT_KEY_PRESS:
+    case XCB_INPUT_KEY_RELEASE:
+    case XCB_INPUT_BUTTON_PRESS:
+    case XCB_INPUT_BUTTON_RELEASE:
+    case XCB_INPUT_MOTION:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+Tracer::Tracer(const std::string& path)
+    : file_(std::fopen(path.c_str(), "we")) {
+  DCHECK(instance_ == nullptr);
+  if (file_ == nullptr) {
+    throw PError("fopen");
+  }
+  spans_.reserve(kCapacity);
+  std::fputs("[\n", file_);
+  instance_ = this;
+}
+
+Tracer::~Tracer() {
+  instance_ = nullptr;
+  Flush();
+  std::fputs("\n]\n", file_);
+  std::fclose(file_);
+}
+
+void Tracer::Record(const Span& span) {
+  if (spans_.size() == kCapacity) {
+    dropped_++;
+    return;
+  }
+  spans_.push_back(span);
+}
+
+void Tracer::Flush() {
+  const auto pid = getpid();
+  for (const auto& span : spans_) {
+    std::fprintf(file_,
+                 "%s{\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"cat\":\"%s\","
+                 "\"name\":\"%s\",\"ts\":%lld,\"dur\":%lld",
+                 first_record_ ? "" : ",\n", pid, pid, span.category,
+                 span.name, Microseconds(span.start),
+                 Microseconds(span.end) - Microseconds(span.start));
+    if (span.has_event && span.extension != 0) {
+      std::fprintf(file_,
+                   ",\"args\":{\"response_type\":%u,\"extension\":%u,"
+                   "\"event_type\":%u}",
+                   span.response_type, span.extension, span.event_type);
+    } else if (span.has_event) {
+      std::fprintf(file_,
+                   ",\"args\":{\"response_type\":%u,\"window\":\"0x%x\","
+                   "\"server_time\":%u}",
+                   span.response_type, span.window, span.server_time);
+    }
+    std::fputs("}", file_);
+    first_record_ = false;
+  }
+  spans_.clear();
+
+  if (dropped_ != 0) {
+    std::fprintf(file_,
+                 "%s{\"ph\":\"i\",\"s\":\"p\",\"pid\":%d,\"tid\":%d,"
+                 "\"name\":\"dropped spans\",\"ts\":%lld,"
+                 "\"args\":{\"count\":%llu}}",
+                 first_record_ ? "" : ",\n", pid, pid,
+                 Microseconds(Clock::now()),
+                 static_cast<unsigned long long>(dropped_));
+    first_record_ = false;
+    dropped_ = 0;
+  }
+  std::fflush(file_);
+}
+
+void ScopedTraceSpan::SetEvent(const Event& event) {
+  if (tracer_ == nullptr) {
+    return;
+  }
+  span_.has_event = true;
+  span_.response_type = event.ResponseType();
+  switch (event.ResponseType()) {
+    case XCB_CIRCULATE_NOTIFY:
+      span_.window = As<xcb_circulate_notify_event_t>(event)->window;
+      break;
+    case XCB_CONFIGURE_NOTIFY:
+      span_.window = As<xcb_configure_notify_event_t>(event)->window;
+      break;
+    case XCB_DESTROY_NOTIFY:
+      span_.window = As<xcb_destroy_notify_event_t>(event)->window;
+      break;
+    case XCB_GRAVITY_NOTIFY:
+      span_.window = As<xcb_gravity_notify_event_t>(event)->window;
+      break;
+    case XCB_MAP_NOTIFY:
+      span_.window = As<xcb_map_notify_event_t>(event)->window;
+      break;
+    case XCB_PROPERTY_NOTIFY:
+      span_.window = As<xcb_property_notify_event_t>(event)->window;
+      span_.server_time = As<xcb_property_notify_event_t>(event)->time;
+      break;
+    case XCB_REPARENT_NOTIFY:
+      span_.window = As<xcb_reparent_notify_event_t>(event)->window;
+      break;
+    case XCB_UNMAP_NOTIFY:
+      span_.window = As<xcb_unmap_notify_event_t>(event)->window;
+      break;
+    case XCB_GE_GENERIC: {
+      const auto* generic = As<xcb_ge_generic_event_t>(event);
+      if (generic->extension != tracer_->xinput_major_opcode() ||
+          !IsXiDeviceEvent(generic->event_type)) {
+        // Other generic events, like Present's, have their own layouts.
+        span_.extension = generic->extension;
+        span_.event_type = generic->event_type;
+        break;
+      }
+      const auto* device_event = As<xcb_input_key_press_event_t>(event);
+      span_.window = device_event->event;
+      span_.server_time = device_event->time;
+      break;
+    }
+    default:
+      break;
+  }
+}
@@ -0,0 +1,124 @@
+// x-active-window-indicator: An X11 utility that signals the active window
+// Copyright (C) 2019 <tomKPZ@gmail.com>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+class Event;
+
+// Records spans into a preallocated buffer and writes them to a file in
+// the Chrome trace event format, which chrome://tracing and Perfetto
+// load.  Recording only copies a few words; formatting and writing
+// happen in Flush(), which the event loop calls before it blocks.
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Span {
+    const char* category;
+    const char* name;
+    Clock::time_point start;
+    Clock::time_point end;
+
+    // Set for spans that handle an event.
+    bool has_event = false;
+    uint8_t response_type = 0;
+    uint32_t window = 0;
+    uint32_t server_time = 0;
+
+    // Set for generic events instead of |window| and |server_time|,
+    // unless they are XI2 device events.
+    uint8_t extension = 0;
+    uint16_t event_type = 0;
+  };
+
+  // Throws PError if |path| cannot be opened.  Only one Tracer may exist
+  // at a time.
+  explicit Tracer(const std::string& path);
+  ~Tracer();
+
+  // Returns the active tracer, or null if tracing is off.
+  static auto Get() -> Tracer* { return instance_; }
+
+  // Spans recorded while the buffer is full are dropped and counted.
+  void Record(const Span& span);
+
+  void Flush();
+
+  // Generic events are only decoded as XI2 device events if they come
+  // from the extension with |opcode|.
+  void set_xinput_major_opcode(uint8_t opcode) {
+    xinput_major_opcode_ = opcode;
+  }
+  [[nodiscard]] auto xinput_major_opcode() const -> uint8_t {
+    return xinput_major_opcode_;
+  }
+
+ private:
+  static constexpr std::size_t kCapacity = 4096;
+
+  inline static Tracer* instance_ = nullptr;
+
+  std::FILE* file_;
+  std::vector<Span> spans_;
+  uint64_t dropped_ = 0;
+  bool first_record_ = true;
+  uint8_t xinput_major_opcode_ = 0;
+
+  DELETE_SPECIAL_MEMBERS(Tracer);
+};
+
+// Records a span from construction to destruction if tracing is on.
+class ScopedTraceSpan {
+ public:
+  ScopedTraceSpan(const char* category, const char* name)
+      : tracer_(Tracer::Get()) {
+    if (tracer_ != nullptr) {
+      span_.category = category;
+      span_.name = name;
+      span_.start = Tracer::Clock::now();
+    }
+  }
+
+  ~ScopedTraceSpan() {
+    if (tracer_ != nullptr) {
+      span_.end = Tracer::Clock::now();
+      tracer_->Record(span_);
+    }
+  }
+
+  // Annotates the span with the type, window and server time of |event|.
+  void SetEvent(const Event& event);
+
+ private:
+  Tracer* tracer_;
+  Tracer::Span span_{};
+
+  DELETE_SPECIAL_MEMBERS(ScopedTraceSpan);
+};
+
+#define TRACE_SPAN_NAME_AUX(line) trace_span_##line
+#define TRACE_SPAN_NAME(line) TRACE_SPAN_NAME_AUX(line)
+#define TRACE_SPAN(category, name) \
+  ScopedTraceSpan TRACE_SPAN_NAME(__LINE__)(category, name)
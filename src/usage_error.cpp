@@ -22,7 +22,9 @@
 namespace {
 
 const char* k_usage_message = R"(
-usage: x-active-window-indicator [-h] [-c COLOR] [-w WIDTH]
+usage: x-active-window-indicator [-h] [-c COLOR] [-w WIDTH] [-b STRATEGY]
+                                 [-p] [-r] [-t MS] [-s MS] [-f] [-n N] [-i US]
+                                 [-T FILE] [-m PATH] [-R FILE] [-P FILE]
 
 An X11 utility that signals the active window
 
@@ -30,6 +32,35 @@ optional arguments:
   -h, --help                show this help message and exit
   -c, --border-color COLOR  indicator color in aarrggbb format
   -w, --border-width WIDTH  indicator border width
+  -b, --border-strategy STRATEGY
+                            how to draw the border: "shape" for one
+                            window reshaped on every resize, or "edges"
+                            for four rectangular windows; default shape
+  -p, --startup-profile     print how long each phase of startup took
+  -r, --request-stats       print request and round trip counts and event
+                            queueing delays on exit; they are also
+                            printed on SIGUSR1
+  -t, --request-timeout MS  fail requests whose reply takes longer than MS
+                            milliseconds; default 10000
+  -s, --stall-threshold MS  log requests whose reply takes longer than MS
+                            milliseconds; default 250
+  -f, --frame-pacing        move the indicator at most once per display
+                            refresh
+  -n, --idle-events N       during an event flood, update the indicator
+                            at least every N events; default 256
+  -i, --idle-interval US    during an event flood, update the indicator
+                            at least every US microseconds; default 4000
+  -T, --trace FILE          write a Chrome trace of event handling, idle
+                            passes and round trips to FILE, viewable in
+                            chrome://tracing or Perfetto
+  -m, --metrics-socket PATH serve metrics in the Prometheus text format on
+                            the Unix socket PATH, or on an abstract socket
+                            if PATH starts with @
+  -R, --record FILE         record the events and replies received from
+                            the X server to FILE
+  -P, --replay FILE         play back a recording instead of connecting to
+                            the X server, then print how long it took;
+                            use the options it was recorded with
 )";
 
 }  // namespace
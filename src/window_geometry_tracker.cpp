@@ -22,35 +22,86 @@
 
 #include <forward_list>
 
+#include "allocation_counter.h"
 #include "connection.h"
 #include "event.h"
 #include "event_loop.h"
+#include "tracer.h"
 #include "window_geometry_observer.h"
 
+namespace {
+
+// Returns true iff an event with |event_sequence| was generated before
+// the server processed the request with |request_sequence|, so that the
+// reply to the request already reflects the event.  Events carry the low
+// 16 bits of the last request processed.
+auto EventPrecedes(uint16_t event_sequence, unsigned int request_sequence)
+    -> bool {
+  return static_cast<int16_t>(event_sequence -
+                              static_cast<uint16_t>(request_sequence)) < 0;
+}
+
+}  // namespace
+
 WindowGeometryTracker::WindowGeometryTracker(Connection* connection,
                                              EventLoop* event_loop,
                                              const xcb_window_t& window)
     : connection_(connection),
       event_loop_(event_loop),
-      event_dispatcher_(this, event_loop_),
-      window_(window) {
+      window_(window),
+      event_handlers_(
+          event_loop_,
+          {EventHandler::ForWindow<&WindowGeometryTracker::OnConfigureNotify>(
+               this, window_),
+           EventHandler::ForWindow<&WindowGeometryTracker::OnGravityNotify>(
+               this, window_),
+           EventHandler::ForWindow<&WindowGeometryTracker::OnReparentNotify>(
+               this, window_),
+           EventHandler::Ignore<xcb_circulate_notify_event_t>(window_),
+           EventHandler::Ignore<xcb_destroy_notify_event_t>(window_),
+           EventHandler::Ignore<xcb_map_notify_event_t>(window_),
+           EventHandler::Ignore<xcb_unmap_notify_event_t>(window_)}) {
   connection_->SelectEvents(window_, XCB_EVENT_MASK_STRUCTURE_NOTIFY);
 
-  auto tree = XCB_SYNC(xcb_query_tree, connection_, window_);
-  SetParent(tree->parent);
-
-  auto geometry = XCB_SYNC(xcb_get_geometry, connection_, window_);
-  x_ = geometry->x;
-  y_ = geometry->y;
-  width_ = geometry->width;
-  height_ = geometry->height;
-  border_width_ = geometry->border_width;
+  tree_request_ = XCB_ASYNC(
+      xcb_query_tree, connection_,
+      [this](XcbReply<xcb_query_tree_reply_t> tree) {
+        has_tree_ = true;
+        SetParent(tree->parent);
+        WindowPositionChanged();
+      },
+      window_);
+
+  geometry_request_ = XCB_ASYNC(
+      xcb_get_geometry, connection_,
+      [this](XcbReply<xcb_get_geometry_reply_t> geometry) {
+        has_geometry_ = true;
+        x_ = geometry->x;
+        y_ = geometry->y;
+        width_ = geometry->width;
+        height_ = geometry->height;
+        border_width_ = geometry->border_width;
+        TRACE_SPAN("observer", "WindowGeometryChanged");
+        for (auto* observer : observers()) {
+          observer->WindowPositionChanged();
+          observer->WindowSizeChanged();
+          observer->WindowBorderWidthChanged();
+        }
+      },
+      window_);
 }
 
 WindowGeometryTracker::~WindowGeometryTracker() {
   connection_->DeselectEvents(window_, XCB_EVENT_MASK_STRUCTURE_NOTIFY);
 }
 
+auto WindowGeometryTracker::Ready() const -> bool {
+  if (!has_tree_ || !has_geometry_) {
+    return false;
+  }
+  return parent_ ? parent_->Ready() : true;
+}
+
 auto WindowGeometryTracker::X() const -> int16_t {
   return parent_ ? CheckedCast<int16_t>(parent_->X() + x_) : 0;
 }
@@ -59,110 +110,82 @@ auto WindowGeometryTracker::Y() const -> int16_t {
   return parent_ ? CheckedCast<int16_t>(parent_->Y() + y_) : 0;
 }
 
-auto WindowGeometryTracker::DispatchEvent(const Event& event) -> bool {
-  union {
-    const xcb_generic_event_t* generic;
-
-    const xcb_circulate_notify_event_t* circulate;
-    const xcb_configure_notify_event_t* configure;
-    const xcb_destroy_notify_event_t* destroy;
-    const xcb_gravity_notify_event_t* gravity;
-    const xcb_map_notify_event_t* map;
-    const xcb_reparent_notify_event_t* reparent;
-    const xcb_unmap_notify_event_t* unmap;
-  } structure_event{};
-  structure_event.generic = event.event();
-
-  switch (event.ResponseType()) {
-    case XCB_CIRCULATE_NOTIFY:
-      return structure_event.circulate->event == window_;
-    case XCB_CONFIGURE_NOTIFY: {
-      const auto* configure = structure_event.configure;
-
-      if (configure->event != window_) {
-        return false;
-      }
-      if (event.SendEvent()) {
-        return true;
-      }
-
-      if (x_ != configure->x || y_ != configure->y) {
-        x_ = configure->x;
-        y_ = configure->y;
-        for (auto* observer : observers()) {
-          observer->WindowPositionChanged();
-        }
-      }
-
-      if (width_ != configure->width || height_ != configure->height) {
-        width_ = configure->width;
-        height_ = configure->height;
-        for (auto* observer : observers()) {
-          observer->WindowSizeChanged();
-        }
-      }
-
-      if (border_width_ != configure->border_width) {
-        border_width_ = configure->border_width;
-        for (auto* observer : observers()) {
-          observer->WindowBorderWidthChanged();
-        }
-      }
+void WindowGeometryTracker::OnConfigureNotify(
+    const xcb_configure_notify_event_t& configure) {
+  // An event that was reordered behind the reply to GetGeometry must not
+  // overwrite the newer geometry of the reply.
+  if (IsSendEvent(configure.response_type) ||
+      EventPrecedes(configure.sequence, geometry_request_.sequence())) {
+    return;
+  }
 
-      return true;
+  if (x_ != configure.x || y_ != configure.y) {
+    x_ = configure.x;
+    y_ = configure.y;
+    TRACE_SPAN("observer", "WindowPositionChanged");
+    for (auto* observer : observers()) {
+      observer->WindowPositionChanged();
     }
-    case XCB_DESTROY_NOTIFY:
-      return structure_event.destroy->event == window_;
-    case XCB_GRAVITY_NOTIFY: {
-      const auto* gravity = structure_event.gravity;
-
-      if (gravity->event != window_) {
-        return false;
-      }
-      if (event.SendEvent()) {
-        return true;
-      }
-
-      x_ = gravity->x;
-      y_ = gravity->y;
-      for (auto* observer : observers()) {
-        observer->WindowPositionChanged();
-      }
-
-      return true;
+  }
+
+  if (width_ != configure.width || height_ != configure.height) {
+    width_ = configure.width;
+    height_ = configure.height;
+    TRACE_SPAN("observer", "WindowSizeChanged");
+    for (auto* observer : observers()) {
+      observer->WindowSizeChanged();
     }
-    case XCB_MAP_NOTIFY:
-      return structure_event.map->event == window_;
-    case XCB_REPARENT_NOTIFY: {
-      const auto* reparent = structure_event.reparent;
-
-      if (reparent->event != window_) {
-        return false;
-      }
-      if (event.SendEvent()) {
-        return true;
-      }
-
-      SetParent(reparent->parent);
-      for (auto* observer : observers()) {
-        observer->WindowPositionChanged();
-      }
-
-      return true;
+  }
+
+  if (border_width_ != configure.border_width) {
+    border_width_ = configure.border_width;
+    TRACE_SPAN("observer", "WindowBorderWidthChanged");
+    for (auto* observer : observers()) {
+      observer->WindowBorderWidthChanged();
     }
-    case XCB_UNMAP_NOTIFY:
-      return structure_event.unmap->event == window_;
   }
-  return false;
+}
+
+void WindowGeometryTracker::OnGravityNotify(
+    const xcb_gravity_notify_event_t& gravity) {
+  if (IsSendEvent(gravity.response_type) ||
+      EventPrecedes(gravity.sequence, geometry_request_.sequence())) {
+    return;
+  }
+
+  x_ = gravity.x;
+  y_ = gravity.y;
+  TRACE_SPAN("observer", "WindowPositionChanged");
+  for (auto* observer : observers()) {
+    observer->WindowPositionChanged();
+  }
+}
+
+void WindowGeometryTracker::OnReparentNotify(
+    const xcb_reparent_notify_event_t& reparent) {
+  if (IsSendEvent(reparent.response_type) ||
+      EventPrecedes(reparent.sequence, tree_request_.sequence())) {
+    return;
+  }
+
+  SetParent(reparent.parent);
+  TRACE_SPAN("observer", "WindowPositionChanged");
+  for (auto* observer : observers()) {
+    observer->WindowPositionChanged();
+  }
 }
 
 void WindowGeometryTracker::WindowPositionChanged() {
+  TRACE_SPAN("observer", "WindowPositionChanged");
   for (auto* observer : observers()) {
     observer->WindowPositionChanged();
   }
 }
 
 void WindowGeometryTracker::SetParent(xcb_window_t parent) {
+  // Following the ancestors is part of activation even when it happens
+  // in a reply or a ReparentNotify.
+  ScopedAllocationPhase activation_phase(AllocationPhase::kActivation);
   // |observer_| must be destroyed before |parent_|.  Reset them now
   // to prevent recreating them in the wrong order below.
   observer_.reset();
@@ -17,11 +17,14 @@
 
 #pragma once
 
+#include <xcb/xproto.h>
+
 #include <cstdint>
 #include <memory>
 
-#include "event_dispatcher.h"
+#include "async_request.h"
 #include "observable.h"
+#include "scoped_event_handlers.h"
 #include "scoped_observer.h"
 #include "util.h"
 #include "window_geometry_observer.h"
@@ -29,11 +32,9 @@
 using xcb_window_t = uint32_t;
 
 class Connection;
-class Event;
 class EventLoop;
 
-class WindowGeometryTracker : public EventDispatcher,
-                              public Observable<WindowGeometryObserver>,
+class WindowGeometryTracker : public Observable<WindowGeometryObserver>,
                               public WindowGeometryObserver {
  public:
   WindowGeometryTracker(Connection* connection,
@@ -41,6 +42,10 @@ class WindowGeometryTracker : public EventDispatcher,
                         const xcb_window_t& window);
   ~WindowGeometryTracker() override;
 
+  // Returns false until the geometry of this window and all of its
+  // ancestors has been received.  Observers are notified when it is.
+  [[nodiscard]] auto Ready() const -> bool;
+
   [[nodiscard]] auto X() const -> int16_t;
   [[nodiscard]] auto Y() const -> int16_t;
 
@@ -50,32 +55,39 @@ class WindowGeometryTracker : public EventDispatcher,
   [[nodiscard]] auto border_width() const -> uint16_t { return border_width_; }
 
  protected:
-  // EventDispatcher:
-  auto DispatchEvent(const Event& event) -> bool override;
-
   // WindowGeometryObserver:
   void WindowPositionChanged() override;
 
  private:
+  void OnConfigureNotify(const xcb_configure_notify_event_t& configure);
+  void OnGravityNotify(const xcb_gravity_notify_event_t& gravity);
+  void OnReparentNotify(const xcb_reparent_notify_event_t& reparent);
+
   void SetParent(xcb_window_t parent);
 
   Connection* connection_;
   EventLoop* event_loop_;
-  ScopedObserver<EventDispatcher> event_dispatcher_;
   xcb_window_t window_;
+  ScopedEventHandlers event_handlers_;
 
   // Position relative to the parent window.  (0, 0) if this is the
   // root window.
-  int16_t x_;
-  int16_t y_;
+  bool has_tree_ = false;
+  bool has_geometry_ = false;
+
+  int16_t x_ = 0;
+  int16_t y_ = 0;
 
-  uint16_t width_;
-  uint16_t height_;
+  uint16_t width_ = 0;
+  uint16_t height_ = 0;
 
-  uint16_t border_width_;
+  uint16_t border_width_ = 0;
 
   std::unique_ptr<WindowGeometryTracker> parent_;
   std::unique_ptr<ScopedObserver<WindowGeometryObserver>> observer_;
 
+  AsyncRequest tree_request_;
+  AsyncRequest geometry_request_;
+
   DELETE_SPECIAL_MEMBERS(WindowGeometryTracker);
 };